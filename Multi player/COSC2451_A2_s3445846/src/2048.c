@@ -9,16 +9,27 @@
 #include <time.h>
 #include <string.h>
 #include <unistd.h>
+#include <float.h>
 #include "key_algorithm.h"
 #include "menu.h"
 #include "score.h"
-
-/** @struct Structure containing the properties of 2 players.
- */
-struct player {
-	int *table1; int *table2; int y;  int inp;  int score1; int score2; int timer; 	
-	bool isStuck1; bool isMatch1; bool isFail1; bool isFail2; bool isStuck2; bool isMatch2; 
-};
+#include "session.h"
+#include "history.h"
+#include "arena.h"
+#include "eval.h"
+#include "ntuple.h"
+#include "rollout.h"
+#include "mcts.h"
+#include "search.h"
+#include "hint.h"
+#include "rng.h"
+#include "ai.h"
+
+/* moves generated for the chosen board size, selected once in main() */
+static const struct moves *moves;
+
+/* the file the game is saved in, empty when it is not saved */
+static char session_path[32];
 
 /** @brief Initialise the game board and setup the 
  * color pairs when starting the game.
@@ -26,9 +37,10 @@ struct player {
  * @param s the current score 
  * @param f game status (fail or not)
  * @param y colum length of game board
+ * @param seed random seed of the game board
  * @return none
  */
-void init_table(int *a, int *s, bool *f, int *y);
+void init_table(unsigned char *a, long long *s, bool *f, int *y, unsigned int *seed);
 
 /** @brief Initialize the game boards in 2-player game mode and 
  * setup the color pairs when starting the game.
@@ -40,10 +52,17 @@ void init_table(int *a, int *s, bool *f, int *y);
  * @param isFail2 player 2's status (fail or not)
  * @param y number of columns of game boards
  * @param inp input from the player
+ * @param seed1 random seed of player 1's game board
+ * @param seed2 random seed of player 2's game board
+ * @return none
+ */
+void init_2_table(unsigned char *table1, long long *score1, bool *isFail1, unsigned char *table2, 
+	long long *score2, bool *isFail2, int *y, int *timer, unsigned int *seed1, unsigned int *seed2);
+
+/** @brief Setup the color pairs of the game.
  * @return none
  */
-void init_2_table(int *table1, int *score1, bool *isFail1, int *table2, 
-	int *score2, bool *isFail2, int *y, int *timer);
+void init_colors();
 
 /** @brief Print all the current numbers of the game board
  * on the terminal.
@@ -53,7 +72,7 @@ void init_2_table(int *table1, int *score1, bool *isFail1, int *table2,
  * @param y column length of game board
  * @return none
  */
-void print_table(int *a, int *s, bool *f, int *y);
+void print_table(unsigned char *a, long long *s, bool *f, int *y);
 
 /** @brief Print all the current numbers of the 2 game boards.
  * @param table1 the array containing the numbers of player 1's game board
@@ -66,26 +85,41 @@ void print_table(int *a, int *s, bool *f, int *y);
  * @param inp input from the player
  * @return none
  */
-void print_2_table(int *table1, int *score1, bool *isFail1, int *table2, 
-	int *score2, bool *isFail2, int *y, int *timer);
+void print_2_table(unsigned char *table1, long long *score1, bool *isFail1, unsigned char *table2, 
+	long long *score2, bool *isFail2, int *y, int *timer);
 
-/** @brief Add a new random number to the board (2 or 4).
- * @param a the array containing the numbers of the game board
- * @param f game status (game over or not)
+/** @brief Display game board's sizes for players to choose.
+ * @return none
+ */
+void table_choices();
+
+/** @brief Get the width of a slot so the game boards fit the terminal.
  * @param y colum length of game board
+ * @param tables number of game boards printed side by side
+ * @return int
+ */
+int cell_width(int y, int tables);
+
+/** @brief Print a number of the game board in its color,
+ * the board stores the exponent of 2 of each number.
+ * @param e the exponent (0 for an empty slot)
+ * @param width width of the slot
  * @return none
  */
-void add_value(int *a, bool *f, int *y);
+void print_cell(unsigned char e, int width);
 
-/** @brief Display game board's sizes for players to choose.
+/** @brief Print the empty lines between 2 rows of the game board.
+ * @param y colum length of game board
  * @return none
  */
-void table_choices();
+void print_gap(int y);
 
 /** @brief Display game board's sizes for players to choose.
  * @param inp input from player
+ * @param ai1 AI of the left table in AI vs AI mode (AI_MEDIUM or AI_MCTS)
+ * @param level index of the AI level in ai_levels in Human vs AI mode
  */
-void game_choices(int *inp, int *timer);
+void game_choices(int *inp, int *timer, int *ai1, int *level);
 
 /** @brief Display the menu for player to choose time mode.
  */
@@ -97,13 +131,13 @@ void time_choice();
  * @param y colum length of game board
  * @return none
  */
-void reset_table(int *a, int *y);
+void reset_table(unsigned char *a, int *y);
 
-/** @brief Generate random AI (easy level).
+/** @brief Generate the AI of the chosen level (Human vs AI mode).
  * @param param pointer to the "struct player"
  * @return none
  */
-void *random_AI(void *param);
+void *level_AI(void *param);
 
 /** @brief Generate the move of human player 1.
  * @param param pointer to the "struct player"
@@ -129,6 +163,12 @@ void *count_down(void* param);
  */
 void *medium_AI(void* param);
 
+/** @brief Generate the Monte Carlo tree search AI (AI vs AI Mode).
+ * @param param pointer to the "struct player"
+ * @return none
+ */
+void *mcts_AI(void* param);
+
 /** @brief Generate smart AI (hard Mode).
  * @param param pointer to the "struct player"
  * @return none
@@ -141,20 +181,17 @@ void *smart_AI(void* param);
  * @param length board size
  * @return bool
  */
-bool check_stuck(int *a, int *a_clone, int length);
-
-/** @brief Count the number of matching pairs in the board
- * @param a the array containing the numbers of the game board
- * @param y colum length of game board
- * @return int
- */
-int check_matchingPair(int *a, int *y);
+bool check_stuck(unsigned char *a, unsigned char *a_clone, int length);
 
 /**
  * @brief Main function.
+ * @param argc number of arguments
+ * @param argv "--resume [file]" restores the game of a session file (session.sav by default),
+ * "--deadline ms" sets the thinking time of the AI per move in timed mode,
+ * "--cutoff p" sets the chance below which its search does not look further
  * @return integer
  */
-int main() {	
+int main(int argc, char *argv[]) {	
 	initscr();  /* Initialize the ncurses library. */
 	cbreak();  /* Take input chars one at a time, no wait for \n. */
 	keypad(stdscr, TRUE);  /* Enable keyboard mapping. */	
@@ -163,75 +200,116 @@ int main() {
 	curs_set(0);  /* hide the terminal cursor */
     pthread_t threads[3];
 
-	/* column length of game board */
-	int y = 0;
-	int inp = 0;  /* store the input's value in the HEAP. */	
-
-	print_menu();  /* display main menu */
-	table_choices();  /* display game board's sizes */
-	/* get input about the size from users */	
-	while(inp != '1' && inp != '2' && inp != '3') {
-		inp = getch();  
-
-		if (inp == '1') {
-			y = 3;
-		} else if (inp == '2') {
-			y = 4;
-		} else if (inp == '3')	{
-			y = 5;
+	/* restore the last game, the boards are used directly from the file */
+	struct session *session = NULL;
+	bool resume = false;
+	int deadline = 0;  /* 0: not given */
+	float cutoff = -1;  /* negative: not given */
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--resume") == 0) {
+			resume = true;
+			if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+				snprintf(session_path, sizeof(session_path), "%s", argv[++i]);
+			}
+		} else if (i + 1 < argc && strcmp(argv[i], "--deadline") == 0 && atoi(argv[i + 1]) > 0) {
+			deadline = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "--cutoff") == 0 && atof(argv[i + 1]) >= 0) {
+			cutoff = atof(argv[++i]);
+		}
+	}
+	if (resume == true) {  /* NULL if the game is over or another game is using the file */
+		if (session_path[0] == '\0') {
+			snprintf(session_path, sizeof(session_path), "%s", SESSION_FILE);
 		}
+		session = session_open(session_path, true);
 	}
-	clear();	
-
-	int timer = 0;
-	game_choices(&inp, &timer); /* get the desired game mode of player */
-
-	/* instantiate the values of the struct */	
-	struct player p;	
-	p.table1 = malloc(sizeof(int) * (y * y));  
-	p.score1 = 0;
-	p.isStuck1 = true; 
-	p.isMatch1 = false;
-	p.isFail1 = false;
-	p.y = y;		
-	p.inp = inp;	
-	p.timer = timer;
-	p.table2 = malloc(sizeof(int) * (y * y));  
-	p.score2 = 0;
-	p.isStuck2 = true; 
-	p.isMatch2 = false;
-	p.isFail2 = false;
+	if (session != NULL && deadline > 0) {
+		session->p.deadline = deadline;
+	}
+	if (session != NULL && cutoff >= 0) {
+		session->p.cutoff = cutoff;
+	}
+
+	if (session == NULL) {
+		/* column length of game board */
+		int y = 0;
+		int inp = 0;  /* store the input's value in the HEAP. */	
+
+		print_menu();  /* display main menu */
+		table_choices();  /* display game board's sizes */
+		/* get input about the size from users */	
+		while(y == 0) {
+			inp = getch();  
+
+			if (inp >= '1' && inp <= '0' + MAX_LENGTH - 2) {  /* '1' is 3 x 3 */
+				y = inp - '0' + 2;
+			}
+		}
+		clear();	
+
+		int timer = 0;
+		int ai1 = AI_MEDIUM;
+		int level = 0;
+		game_choices(&inp, &timer, &ai1, &level); /* get the desired game mode of player */
+
+		session = session_start(session_path, sizeof(session_path));  /* keeps the games left to resume */
+		if (session == NULL) {
+			endwin();
+			return 1;
+		}
+
+		/* instantiate the values of the struct */	
+		struct player *p = &(session->p);
+		p->score1 = 0;
+		p->isStuck1 = true; 
+		p->isMatch1 = false;
+		p->isFail1 = false;
+		p->y = y;		
+		p->inp = inp;	
+		p->timer = timer;
+		p->time_limit = timer;
+		p->score2 = 0;
+		p->isStuck2 = true; 
+		p->isMatch2 = false;
+		p->isFail2 = false;
+		p->seed1 = time(NULL) ^ getpid();
+		p->seed2 = p->seed1 * 2654435761u;
+		p->ai1 = ai1;
+		p->level = level;
+		p->deadline = deadline > 0 ? deadline : AI_DEADLINE;
+		p->cutoff = cutoff >= 0 ? cutoff : SEARCH_CUTOFF;
+		session->mode = inp;
+	}
+
+	struct player *p = &(session->p);
+	int inp = session->mode;
+	moves = get_moves(p->y);
 
 	if (inp == 11) {  /* player chooses 1-player: Human */				
-		pthread_create(&threads[0], NULL, first_player_move, &p); /* start thread */
+		pthread_create(&threads[0], NULL, first_player_move, p); /* start thread */
 	} else if (inp == 12) {  /* player chooses 1-player: AI */
-		pthread_create(&threads[0], NULL, smart_AI, &p);
+		pthread_create(&threads[0], NULL, smart_AI, p);
+	} else if (inp == 13) {  /* player chooses 1-player: AI (Monte Carlo) */
+		pthread_create(&threads[0], NULL, smart_AI, p);
 	} else if (inp == 211) {  /* player chooses 2-player: Human vs Human (unlimited) */				
-		pthread_create(&threads[0], NULL, hvh_player_move, &p);		
+		pthread_create(&threads[0], NULL, hvh_player_move, p);		
 	} else if (inp == 212) {  /* player chooses 2-player: Human vs Human (limited) */				
-		pthread_create(&threads[1], NULL, count_down, &p);
-		pthread_create(&threads[0], NULL, hvh_player_move, &p);		
-	} else if (inp == 2211)	{  /* player chooses 2-player: Human vs AI (Easy - Unlimited) */		
-		pthread_create(&threads[0], NULL, first_player_move, &p);
-		pthread_create(&threads[1], NULL, random_AI, &p);
-	} else if (inp == 2212)	{  /* player chooses 2-player: Human vs AI (Easy - Limited) */		
-		pthread_create(&threads[0], NULL, count_down, &p);
-		pthread_create(&threads[1], NULL, first_player_move, &p);
-		pthread_create(&threads[2], NULL, random_AI, &p);		
-	} else if (inp == 2221) {  /* player chooses 2-player: Human vs AI (Hard - Unlimited) */		
-		pthread_create(&threads[0], NULL, first_player_move, &p);
-		pthread_create(&threads[1], NULL, smart_AI, &p);
-	} else if (inp == 2222) {  /* player chooses 2-player: Human vs AI (Hard - Limited) */		
-		pthread_create(&threads[0], NULL, count_down, &p);
-		pthread_create(&threads[1], NULL, first_player_move, &p);
-		pthread_create(&threads[2], NULL, smart_AI, &p);		
+		pthread_create(&threads[1], NULL, count_down, p);
+		pthread_create(&threads[0], NULL, hvh_player_move, p);		
+	} else if (inp == 221)	{  /* player chooses 2-player: Human vs AI (Unlimited), p->level is the AI level */		
+		pthread_create(&threads[0], NULL, first_player_move, p);
+		pthread_create(&threads[1], NULL, level_AI, p);
+	} else if (inp == 222)	{  /* player chooses 2-player: Human vs AI (Limited) */		
+		pthread_create(&threads[0], NULL, count_down, p);
+		pthread_create(&threads[1], NULL, first_player_move, p);
+		pthread_create(&threads[2], NULL, level_AI, p);		
 	} else if (inp == 231) {  /* player chooses 2-player: AI vs AI (Unlimited) */		
-		pthread_create(&threads[0], NULL, smart_AI, &p);
-		pthread_create(&threads[1], NULL, medium_AI, &p);
+		pthread_create(&threads[0], NULL, smart_AI, p);
+		pthread_create(&threads[1], NULL, p->ai1 == AI_MCTS ? mcts_AI : medium_AI, p);
 	} else {  /* player chooses 2-player: AI vs AI (limited) */		
-		pthread_create(&threads[0], NULL, count_down, &p);
-		pthread_create(&threads[1], NULL, smart_AI, &p);
-		pthread_create(&threads[2], NULL, medium_AI, &p);		
+		pthread_create(&threads[0], NULL, count_down, p);
+		pthread_create(&threads[1], NULL, smart_AI, p);
+		pthread_create(&threads[2], NULL, p->ai1 == AI_MCTS ? mcts_AI : medium_AI, p);		
 	}
 
 	pthread_exit(NULL);  /* exit thread */			
@@ -239,7 +317,7 @@ int main() {
 	return 0;
 }
 
-void init_table(int *a, int *s, bool *f, int *y) {				
+void init_colors() {
 	if (has_colors()) {  /* check if Terminal supports colors */
 		start_color();
 		/* initialize color pairs for the game */		 
@@ -251,126 +329,49 @@ void init_table(int *a, int *s, bool *f, int *y) {
 		init_pair(6, COLOR_MAGENTA, COLOR_BLACK);	
 		init_pair(7, COLOR_WHITE, COLOR_BLACK);	
 	}	
+}
 
-	add_value(a, f, y);
-	add_value(a, f, y);
+void init_table(unsigned char *a, long long *s, bool *f, int *y, unsigned int *seed) {				
+	init_colors();
+
+	add_value(a, f, y, seed);
+	add_value(a, f, y, seed);
 	print_table(a, s, f, y);
 }
 
-void init_2_table(int *table1, int *score1, bool *isFail1, int *table2, 
-	int *score2, bool *isFail2, int *y, int *timer) {
-	if (has_colors()) {  /* check if Terminal supports colors */
-		start_color();
-		/* initialize color pairs for the game */		 
-		init_pair(1, COLOR_YELLOW, COLOR_BLACK);
-		init_pair(2, COLOR_RED, COLOR_BLACK);
-		init_pair(3, COLOR_GREEN, COLOR_BLACK);
-		init_pair(4, COLOR_BLUE, COLOR_BLACK);
-		init_pair(5, COLOR_CYAN, COLOR_BLACK);	
-		init_pair(6, COLOR_MAGENTA, COLOR_BLACK);	
-		init_pair(7, COLOR_WHITE, COLOR_BLACK);	
-	}	
+void init_2_table(unsigned char *table1, long long *score1, bool *isFail1, unsigned char *table2, 
+	long long *score2, bool *isFail2, int *y, int *timer, unsigned int *seed1, unsigned int *seed2) {
+	init_colors();
 
 	/* add 2 initial numbers for 2 game boards */
-	add_value(table1, isFail1, y);	add_value(table1, isFail1, y);
-	add_value(table2, isFail2, y);  add_value(table2, isFail2, y);
+	add_value(table1, isFail1, y, seed1);	add_value(table1, isFail1, y, seed1);
+	add_value(table2, isFail2, y, seed2);  add_value(table2, isFail2, y, seed2);
 	print_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);
 }
 
-void add_value(int *a, bool *f, int *y) {
-	int slots = *y * *y;
-
-	int init_values[] = {2, 4};
-	/* array to store location of empty slot of the table */	 
-	int avail_space[slots];  
-
-	/* check if the table has at least 1 empty slot */	 
-	bool check_value = false;  
-	int count = 0;
-	for (int i = 0; i < slots; ++i) {
-		if (*(a + i) == 0) {			
-			avail_space[count] = i;	 /* store the location */		
-			count++;
-			check_value = true;			
-		} 
-	}	
-
-	if (check_value == true) {  /* the table has at least 1 empty slot */
-		/* generate a random empty slot */
-		srand(time(NULL));  		
-		int random_space = rand() % count;  
-		srand(1);
-
-		/* generate a random number (2 or 4) */
-		srand(time(NULL));
-		int random_value = rand() % 2;
-		srand(1);
-
-		/* add random value to that random slot */
-		a[avail_space[random_space]] = init_values[random_value];	
-	} else {
-		*f = true;  /* change game status to "game over" */
-	}	
-}
-
-void print_table(int *a, int *s, bool *f, int *y) {  	
+void print_table(unsigned char *a, long long *s, bool *f, int *y) {  	
 	printw("\n");
-	int winning_score = 0;
-	if (*y == 3) {
-		winning_score = 1024;
-	} else if (*y == 4)	{
-		winning_score = 2048;
-	} else if (*y == 5)	{
-		winning_score = 4096;
-	}
+	int width = cell_width(*y, 1);
 
 	for (int i = 0; i < *y; ++i)	{	
 		for (int j = 0; j < *y; ++j)	{
-			if (a[i * *y + j] == 0)	{
-				attron(COLOR_PAIR(7));
-				printw("%10d", a[i * *y + j], "");					
-				attroff(COLOR_PAIR(7));
-			} else if (a[i * *y + j] == 2)	{
-				attron(COLOR_PAIR(1));
-				printw("%10d", a[i * *y + j], "");					
-				attroff(COLOR_PAIR(1));
-			} else if (a[i * *y + j] == 4)	{
-				attron(COLOR_PAIR(2));
-				printw("%10d", a[i * *y + j], "");					
-				attroff(COLOR_PAIR(2));
-			} else if (a[i * *y + j] == 8)	{
-				attron(COLOR_PAIR(3));
-				printw("%10d", a[i * *y + j], "");					
-				attroff(COLOR_PAIR(3));
-			} else if (a[i * *y + j] == 16)	{
-				attron(COLOR_PAIR(4));
-				printw("%10d", a[i * *y + j], "");					
-				attroff(COLOR_PAIR(4));
-			} else if (a[i * *y + j] == 32)	{
-				attron(COLOR_PAIR(5));
-				printw("%10d", a[i * *y + j], "");					
-				attroff(COLOR_PAIR(5));
-			} else {
-				attron(COLOR_PAIR(6));
-				printw("%10d", a[i * *y + j], "");					
-				attroff(COLOR_PAIR(6));
-			}			
+			print_cell(a[i * *y + j], width);
 		}
-		printw("\n\n\n\n");
+		print_gap(*y);
 	}
 		
 	if (*f == false) {  /* game isn't over yet */
 		attron(COLOR_PAIR(2));
-		printw("SCORE: %5d\n\n", *s);		
+		printw("SCORE: %5lld\n\n", *s);		
 		attroff(COLOR_PAIR(2));
 	/* game over and player's score is >= winning score */		
-	} else if (*f == true && *s >= winning_score) {  
-		printw("SCORE: %5d\n\n", *s);		
+	} else if (*f == true && *s >= winning_score(*y)) {  
+		printw("SCORE: %5lld\n\n", *s);		
 		attron(COLOR_PAIR(2));
 		printw("GAME OVER! YOU WON THE GAME :)");		
 		attroff(COLOR_PAIR(2));
 	} else {  /* game over and player's score is < winning score */
-		printw("SCORE: %5d\n\n", *s);		
+		printw("SCORE: %5lld\n\n", *s);		
 		attron(COLOR_PAIR(2));
 		printw("GAME OVER! YOU FAILED THE GAME :(");
 		attroff(COLOR_PAIR(2));
@@ -382,85 +383,31 @@ void print_table(int *a, int *s, bool *f, int *y) {
 	refresh();
 }
 
-void print_2_table(int *table1, int *score1, bool *isFail1, int *table2, 
-	int *score2, bool *isFail2, int *y, int *timer) {  	
+void print_2_table(unsigned char *table1, long long *score1, bool *isFail1, unsigned char *table2, 
+	long long *score2, bool *isFail2, int *y, int *timer) {  	
 
 	if (*timer > 0)  /* print countdown clock if user chooses limitied game mode */
 		printw("%d seconds left\n\n", *timer);
 	else
 		printw("\n");
 
+	int width = cell_width(*y, 2);
+
 	for (int i = 0; i < *y; ++i)	{	
 		for (int j = 0; j < *y; ++j)	{
-			if (table1[i * *y + j] == 0)	{
-				attron(COLOR_PAIR(7));
-				printw("%10d", table1[i * *y + j], "");					
-				attroff(COLOR_PAIR(7));
-			} else if (table1[i * *y + j] == 2)	{
-				attron(COLOR_PAIR(1));
-				printw("%10d", table1[i * *y + j], "");					
-				attroff(COLOR_PAIR(1));
-			} else if (table1[i * *y + j] == 4)	{
-				attron(COLOR_PAIR(2));
-				printw("%10d", table1[i * *y + j], "");					
-				attroff(COLOR_PAIR(2));
-			} else if (table1[i * *y + j] == 8)	{
-				attron(COLOR_PAIR(3));
-				printw("%10d", table1[i * *y + j], "");					
-				attroff(COLOR_PAIR(3));
-			} else if (table1[i * *y + j] == 16)	{
-				attron(COLOR_PAIR(4));
-				printw("%10d", table1[i * *y + j], "");					
-				attroff(COLOR_PAIR(4));
-			} else if (table1[i * *y + j] == 32)	{
-				attron(COLOR_PAIR(5));
-				printw("%10d", table1[i * *y + j], "");					
-				attroff(COLOR_PAIR(5));
-			} else {
-				attron(COLOR_PAIR(6));
-				printw("%10d", table1[i * *y + j], "");					
-				attroff(COLOR_PAIR(6));
-			}				
+			print_cell(table1[i * *y + j], width);
 		}
 
 		printw("\t");
 
 		for (int j = 0; j < *y; ++j)	{
-			if (table2[i * *y + j] == 0)	{
-				attron(COLOR_PAIR(7));
-				printw("%10d", table2[i * *y + j], "");					
-				attroff(COLOR_PAIR(7));
-			} else if (table2[i * *y + j] == 2)	{
-				attron(COLOR_PAIR(1));
-				printw("%10d", table2[i * *y + j], "");					
-				attroff(COLOR_PAIR(1));
-			} else if (table2[i * *y + j] == 4)	{
-				attron(COLOR_PAIR(2));
-				printw("%10d", table2[i * *y + j], "");					
-				attroff(COLOR_PAIR(2));
-			} else if (table2[i * *y + j] == 8)	{
-				attron(COLOR_PAIR(3));
-				printw("%10d", table2[i * *y + j], "");					
-				attroff(COLOR_PAIR(3));
-			} else if (table2[i * *y + j] == 16)	{
-				attron(COLOR_PAIR(4));
-				printw("%10d", table2[i * *y + j], "");					
-				attroff(COLOR_PAIR(4));
-			} else if (table2[i * *y + j] == 32)	{
-				attron(COLOR_PAIR(5));
-				printw("%10d", table2[i * *y + j], "");					
-				attroff(COLOR_PAIR(5));
-			} else {
-				attron(COLOR_PAIR(6));
-				printw("%10d", table2[i * *y + j], "");					
-				attroff(COLOR_PAIR(6));
-			}						
+			print_cell(table2[i * *y + j], width);
 		}
-		printw("\n\n\n\n");
+		print_gap(*y);
 	}
 		
-	printw("\tSCORE (player 1): %d", *score1);
-	printw("\t\t\tSCORE (player 2): %d\n\n", *score2);
+	printw("\tSCORE (player 1): %lld", *score1);
+	printw("\t\t\tSCORE (player 2): %lld\n\n", *score2);
 
 	if (*timer > 0) {  /* the count down is still on */		
 		if (*isFail1 == true) {   /* 1st player fails */
@@ -494,7 +441,7 @@ void print_2_table(int *table1, int *score1, bool *isFail1, int *table2,
 	refresh();
 }
 
-void reset_table(int *a, int *y) {  
+void reset_table(unsigned char *a, int *y) {  
 	int size = *y * *y;
 	for (int i = 0; i < size; ++i) {
 		*(a + i) = 0;
@@ -503,14 +450,39 @@ void reset_table(int *a, int *y) {
 
 void table_choices() {
 	printw("Game board's sizes\n\n");
-	printw("\t1. 3 x 3 (You need at least 1024 to win)\n");
-	printw("\t2. 4 x 4 (You need at least 2048 to win)\n");
-	printw("\t3. 5 x 5 (You need at least 4096 to win)\n\n");
-	printw("Press '1', '2' or '3' to choose the board size.\n");
+	for (int y = 3; y <= MAX_LENGTH; ++y) {
+		printw("\t%d. %d x %d (You need at least %d to win)\n", y - 2, y, y, winning_score(y));
+	}
+	printw("\nPress '1' to '%d' to choose the board size.\n", MAX_LENGTH - 2);
 	refresh();
 }
 
-void game_choices(int *inp, int *timer) {
+int cell_width(int y, int tables) {
+	int width = 100 / (tables * y);  /* the terminal is 110 columns wide */
+	return width > 10 ? 10 : width;
+}
+
+void print_cell(unsigned char e, int width) {
+	int color = 6;  /* the color of the big numbers */
+	if (e == 0) {
+		color = 7;
+	} else if (e <= 5) {  /* 2, 4, ..., 32 have colors 1 to 5 */
+		color = e;
+	}
+
+	attron(COLOR_PAIR(color));
+	printw("%*lld", width, e == 0 ? 0 : 1LL << e);
+	attroff(COLOR_PAIR(color));
+}
+
+void print_gap(int y) {
+	int lines = 24 / y;  /* the terminal is 30 lines high */
+	for (int i = 0; i < lines && i < 4; ++i) {
+		printw("\n");
+	}
+}
+
+void game_choices(int *inp, int *timer, int *ai1, int *level) {
 	*inp = '0';
 	printw("Game mode\n\n");
 	printw("\t1 - 1 player\n");
@@ -525,12 +497,13 @@ void game_choices(int *inp, int *timer) {
 			clear();
 			printw("1 - player mode\n\n");
 			printw("\t1 - Human\n");
-			printw("\t2 - AI\n\n");
-			printw("Press '1' or '2' to choose game mode.\n");
+			printw("\t2 - AI\n");
+			printw("\t3 - AI (Monte Carlo)\n\n");
+			printw("Press '1', '2' or '3' to choose game mode.\n");
 			refresh();
 			*inp = '0';
 
-			while(*inp != '1' && *inp != '2') {
+			while(*inp != '1' && *inp != '2' && *inp != '3') {
 				*inp = getch();  
 
 				if (*inp == '1') {
@@ -539,6 +512,9 @@ void game_choices(int *inp, int *timer) {
 				} else if (*inp == '2') {
 					*inp = 12;
 					break;
+				} else if (*inp == '3') {
+					*inp = 13;
+					break;
 				}
 			}
 			clear();
@@ -582,66 +558,54 @@ void game_choices(int *inp, int *timer) {
 				} else if (*inp == '2') {					
 					clear();
 					printw("AI difficulty\n\n");
-					printw("\t1 - Easy\n");
-					printw("\t2 - Hard\n\n");
-					printw("Press '1' or '2' to choose.\n");
+					for (int i = 0; i < AI_LEVELS; i++) {
+						printw("\t%d - %s\n", i + 1, ai_levels[i].name);
+					}
+					printw("\nPress '1' to '%d' to choose.\n", AI_LEVELS);
 					refresh();						
 					*inp = 0;
 
+					while(*inp < '1' || *inp > '0' + AI_LEVELS) {
+						*inp = getch();
+					}
+					*level = *inp - '1';
+
+					time_choice();
+					*inp = 0;
 					while(*inp != '1' && *inp != '2') {						
 						*inp = getch();  						
 
 						if (*inp == '1') {
-							time_choice();
-							*inp = 0;
-							while(*inp != '1' && *inp != '2') {						
-								*inp = getch();  						
-
-								if (*inp == '1') {
-									*inp = 2211;
-									break;
-								} else if (*inp == '2') {
-									*inp = 2212;
-
-									clear();
-									printw("Enter the time range to play (in minute) then press \"Enter\": ");
-									refresh();
-									scanf("%d", timer);
-									*timer = *timer * 60;
-									break;
-								}
-							}
-
-							clear();	
+							*inp = 221;
 							break;
 						} else if (*inp == '2') {
-							time_choice();
-							*inp = 0;
-							while(*inp != '1' && *inp != '2') {						
-								*inp = getch();  						
-
-								if (*inp == '1') {
-									*inp = 2221;
-									break;
-								} else if (*inp == '2') {
-									*inp = 2222;
-
-									clear();
-									printw("Enter the time range to play (in minute) then press \"Enter\": ");
-									refresh();
-									scanf("%d", timer);
-									*timer = *timer * 60;
-									break;
-								}
-							}
-
-							clear();	
+							*inp = 222;
+
+							clear();
+							printw("Enter the time range to play (in minute) then press \"Enter\": ");
+							refresh();
+							scanf("%d", timer);
+							*timer = *timer * 60;
 							break;
 						}
 					}
+
 					clear();
 					break;
 				} else if (*inp == '3') {
+					clear();
+					printw("AI of the left table\n\n");
+					printw("\t1 - Medium\n");
+					printw("\t2 - Monte Carlo tree search\n\n");
+					printw("Press '1' or '2' to choose.\n");
+					refresh();
+					*inp = 0;
+
+					while(*inp != '1' && *inp != '2') {
+						*inp = getch();
+					}
+					*ai1 = (*inp == '2') ? AI_MCTS : AI_MEDIUM;
+
 					time_choice();
 					*inp = 0;
 					while(*inp != '1' && *inp != '2') {						
@@ -680,94 +644,69 @@ void time_choice() {
 	refresh();	
 }
 
-void *random_AI(void* param) {		
-	struct player *randomAI = (struct player*) param;	
-	int *table1 = randomAI->table1;
-	int *score1 = &(randomAI->score1);	
-	bool *isStuck1 = &(randomAI->isStuck2);
-	bool *isMatch1 = &(randomAI->isMatch2);	
-	int *y = &(randomAI->y);
-	bool *isFail1 = &(randomAI->isFail1);
-	int *timer = &(randomAI->timer);
-	int *inp = &(randomAI->inp);
-	int temp = *inp;
-
-	int *table2 = randomAI->table2;
-	int *score2 = &(randomAI->score2);
-	bool *isStuck2 = &(randomAI->isStuck2);
-	bool *isMatch2 = &(randomAI->isMatch2);	
-	bool *isFail2 = &(randomAI->isFail2);
+void *level_AI(void* param) {		
+	/*This AI plays the right table against the human player
+	 *Every level uses the same search, only its evaluation and its nodes per move change (see ai.c)
+	 *In the timed mode it also stops at the deadline of the move, the thinking time is part of its pace
+	 */
+	struct player *levelAI = (struct player*) param;	
+	unsigned char *table1 = levelAI->table1;
+	long long *score1 = &(levelAI->score1);	
+	int *y = &(levelAI->y);
+	bool *isFail1 = &(levelAI->isFail1);
+	int *timer = &(levelAI->timer);
+	int *inp = &(levelAI->inp);
+	unsigned int *seed2 = &(levelAI->seed2);
+
+	unsigned char *table2 = levelAI->table2;
+	long long *score2 = &(levelAI->score2);
+	bool *isFail2 = &(levelAI->isFail2);
+
+	int pace = (*inp == 222) ? levelAI->deadline : AI_DEADLINE;  /* ms per move */
+	int level = levelAI->level >= 0 && levelAI->level < AI_LEVELS ? levelAI->level : 0;  /* checked with the session */
+	struct rng_stream stream = rng_stream(*seed2, 0, 0);  /* the moves of the Beginner level */
+	struct ai_player *ai = ai_player_start(*y, level, levelAI->cutoff, &stream);
+	struct search_report thought = {0, 0, 0};
 
 	sleep(1);	
 	while (*inp != 27) {  /* player(s) doesn't press Esc */
-		if (*isFail2 == false && *isFail1 == false) {
-			/* generate random */
-			srand(time(NULL));  		
-			int random_move = rand() % 4;  
-			srand(1);
-			
-			if (temp == 231 || temp == 232) {  /* player is in AI vs AI mode */
-				if (random_move == 0) {
-					down(table1, score1, isStuck1, isMatch1, y);							
-				} else if (random_move == 1) {
-					up(table1, score1, isStuck1, isMatch1, y);
-				} else if (random_move == 2) {
-					right(table1, score1, isStuck1, isMatch1, y);
-				} else {
-					left(table1, score1, isStuck1, isMatch1, y);
-				}
+		if (*isFail2 == false && *isFail1 == false && levelAI->quit == false) {
+			int dir = (ai != NULL) ? ai_player_choose(ai, table2, pace, &thought) : -1;  /* no AI: it loses the game */
 
-				check_failing(table1, isFail1, y);  // check if there's any available 
-										   			// move left on the board.									
-
-				if (*isStuck1 == false || *isMatch1 == true) {
-					add_value(table1, isFail1, y);	/* print the table again */											
-					/* clear all UI elements displayed on the terminal */						
-					clear();  	
-					print_2_table(table1, score1, isFail1, table2, 
-						score2, isFail2, y, timer);	
-					sleep(1);					
-				} 
-			} else {  /* in other mode */				
-				if (random_move == 0) {
-					down(table2, score2, isStuck2, isMatch2, y);							
-				} else if (random_move == 1) {
-					up(table2, score2, isStuck2, isMatch2, y);
-				} else if (random_move == 2) {
-					right(table2, score2, isStuck2, isMatch2, y);
-				} else {
-					left(table2, score2, isStuck2, isMatch2, y);
-				}
-
-				check_failing(table2, isFail2, y);  // check if there's any available 
-										   // move left on the board.									
+			if (dir >= 0 && move_table(moves, dir, table2, score2, y) == true) {
+				add_value(table2, isFail2, y, seed2);
+				moves->check_failing(table2, isFail2, y);  // check if there's any available 
+								   // move left on the board.
+			} else {
+				*isFail2 = true;
+			}
 
-				if (*isStuck2 == false || *isMatch2 == true) {
-					add_value(table2, isFail2, y);	/* print the table again */											
-					/* clear all UI elements displayed on the terminal */						
-					clear();  	
+			/* clear all UI elements displayed on the terminal, then print the tables again */
+			clear();  	
+			print_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);	
+			printw("AI %s: depth %d, %ld nodes, %.0f ms", ai_levels[level].name,
+				thought.depth, thought.nodes, thought.ms);
+			refresh();
 
-					if (temp != 2212) {
-						print_2_table(table1, score1, isFail1, table2, 
-							score2, isFail2, y, timer);	
-					}					
-					sleep(1);					
-				} 	
-			}											
+			if (thought.ms < pace) {
+				usleep((pace - thought.ms) * 1000);
+			}
 		} else {
 			clear();  	
 			print_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);				
 			sleep(1);					
 		} 		
 	}	
-	
+
+	if (ai != NULL) {
+		ai_player_stop(ai);
+	}
 	pthread_exit(NULL);
 }
-
 void *first_player_move(void* param) {
 	struct player *player = (struct player*) param;
-	int *table1 = player->table1;
-	int *score1 = &(player->score1);
+	unsigned char *table1 = player->table1;
+	long long *score1 = &(player->score1);
 	bool *isStuck1 = &(player->isStuck1);
 	bool *isMatch1 = &(player->isMatch1);
 	int *y = &(player->y);
@@ -775,32 +714,59 @@ void *first_player_move(void* param) {
 	int *inp = &(player->inp);
 	int *timer = &(player->timer);
 
-	int *table2 = player->table2;
-	int *score2 = &(player->score2);
+	unsigned int *seed1 = &(player->seed1);
+
+	unsigned char *table2 = player->table2;
+	long long *score2 = &(player->score2);
 	bool *isFail2 = &(player->isFail2);
+	unsigned int *seed2 = &(player->seed2);
 
 	int temp = *inp;	
-	int temp_time = *timer;
+	int temp_time = player->time_limit;
 
-	reset_table(table1, y);  /* reset value of the table */
-	reset_table(table2, y);  /* reset value of the table */
-	if (temp == 11) {
-		init_table(table1, score1, isFail1, y);
+	if (player->resumed == true) {  /* continue the boards of the session */
+		player->resumed = false;
+		init_colors();
+		if (temp == 11) {
+			print_table(table1, score1, isFail1, y);
+		} else {
+			print_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);
+		}
 	} else {
-		init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);
-	}	
+		reset_table(table1, y);  /* reset value of the table */
+		reset_table(table2, y);  /* reset value of the table */
+		if (temp == 11) {
+			init_table(table1, score1, isFail1, y, seed1);
+		} else {
+			init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer, seed1, seed2);
+		}	
+	}
+
+	/* positions of the game for undo/redo (1 player mode only), without memory there is no undo */
+	struct history *history = history_start(*y * *y);
+	history_clear(history, table1, *score1, *seed1);
+
+	/* search the board while the player thinks, 'H' shows the best move (1 player mode only) */
+	struct hint *hint = NULL;
+	if (temp == 11) {
+		hint = hint_start(*y, player->cutoff);
+	}
 	
 	while(*inp != 27 && *inp != 27) {  						
 		if (*isFail1 == false && *isFail2 == false) {  // accept up, down, right, left keys 
 								 					   // as long as player(s) doesn't fail.
+			if (hint != NULL) {
+				hint_position(hint, table1);  /* only restarts the search if the board changed */
+			}
 			*inp = getch();  /* get input from keyboard */							
 			switch(*inp) {			
 				case KEY_DOWN:  /* press "DOWN" button */
 					if (*isFail1 == false && *isFail2 == false) {
-						down(table1, score1, isStuck1, isMatch1, y);					
+						moves->down(table1, score1, isStuck1, isMatch1, y);					
 
 						if (*isStuck1 == false || *isMatch1 == true) {
-							add_value(table1, isFail1, y);	/* print the table again */											
+							add_value(table1, isFail1, y, seed1);	/* print the table again */											
+							history_push(history, table1, *score1, *seed1);
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -814,10 +780,11 @@ void *first_player_move(void* param) {
 					break;
 				case KEY_UP:  /* press "UP" button */
 					if (*isFail1 == false && *isFail2 == false) {
-						up(table1, score1, isStuck1, isMatch1, y);					
+						moves->up(table1, score1, isStuck1, isMatch1, y);					
 
 						if (*isStuck1 == false || *isMatch1 == true) {
-							add_value(table1, isFail1, y);	/* print the table again */											
+							add_value(table1, isFail1, y, seed1);	/* print the table again */											
+							history_push(history, table1, *score1, *seed1);
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -832,10 +799,11 @@ void *first_player_move(void* param) {
 					break;
 				case KEY_RIGHT:   // press "RIGHT" button 
 					if (*isFail1 == false && *isFail2 == false) {
-						right(table1, score1, isStuck1, isMatch1, y);					
+						moves->right(table1, score1, isStuck1, isMatch1, y);					
 
 						if (*isStuck1 == false || *isMatch1 == true) {
-							add_value(table1, isFail1, y);	/* print the table again */											
+							add_value(table1, isFail1, y, seed1);	/* print the table again */											
+							history_push(history, table1, *score1, *seed1);
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -850,10 +818,11 @@ void *first_player_move(void* param) {
 					break;
 				case KEY_LEFT:  /* press "LEFT" button */
 					if (*isFail1 == false && *isFail2 == false) {
-						left(table1, score1, isStuck1, isMatch1, y);					
+						moves->left(table1, score1, isStuck1, isMatch1, y);					
 
 						if (*isStuck1 == false || *isMatch1 == true) {
-							add_value(table1, isFail1, y);	/* print the table again */											
+							add_value(table1, isFail1, y, seed1);	/* print the table again */											
+							history_push(history, table1, *score1, *seed1);
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -874,16 +843,44 @@ void *first_player_move(void* param) {
 					reset_table(table2, y);  /* reset value of the table */
 					clear();
 					if (temp == 11) {
-						init_table(table1, score1, isFail1, y);
+						init_table(table1, score1, isFail1, y, seed1);
 					} else {
-						init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);
+						init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer, seed1, seed2);
 					}
+					history_clear(history, table1, *score1, *seed1);
 					break;		
+				case 'u':  /* press 'U' to undo the last move */
+				case 'y':  /* press 'Y' to redo the undone move */
+					if (temp == 11) {
+						if (*inp == 'u') {
+							history_undo(history, table1, score1, seed1);
+						} else {
+							history_redo(history, table1, score1, seed1);
+						}
+						clear();
+						print_table(table1, score1, isFail1, y);
+					}
+					break;
+				case 'h':  /* press 'H' to see the best move */
+					if (hint != NULL) {
+						const char *names[4] = {"DOWN", "UP", "LEFT", "RIGHT"};
+						int depth = 0;
+						int best = hint_best(hint, &depth);
+						clear();
+						print_table(table1, score1, isFail1, y);
+						if (best >= 0) {
+							printw("Hint: %s (looking %d moves ahead)", names[best], depth);
+						} else {
+							printw("Hint: still thinking, press H again");
+						}
+						refresh();
+					}
+					break;
 				default:				
 					break;
 			}		
 
-			check_failing(table1, isFail1, y);  // check if there's any available 
+			moves->check_failing(table1, isFail1, y);  // check if there's any available 
 											  				   // move left on the board.				    									
 		} else {  /* player fails */
 			clear(); 
@@ -891,7 +888,7 @@ void *first_player_move(void* param) {
 			if (temp == 11) {
 				print_table(table1, score1, isFail1, y);
 				clear();
-	            store_score(score1); /* Store current score of player */
+	            store_score(score1); /* Store current score of player, in the unverified list */
 	            print_score(1); /* Print Top 10 scores */
 	            /* Print the game table again */
 	            if (temp == 11) {
@@ -915,24 +912,33 @@ void *first_player_move(void* param) {
 					reset_table(table2, y);  /* reset value of the table */
 					clear();
 					if (temp == 11) {
-						init_table(table1, score1, isFail1, y);
+						init_table(table1, score1, isFail1, y, seed1);
 					} else {
-						init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);
+						init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer, seed1, seed2);
 					}
+					history_clear(history, table1, *score1, *seed1);
 					break;		
 				}
 			}			
 		}				
 	}
 
-	*isFail1 = true; *isFail2 = true;
-	free(table1); free(table2);
+	/* stop the other threads, the boards stay in the session file */
+	player->quit = true;
+	if (hint != NULL) {
+		hint_stop(hint);
+	}
+	history_stop(history);
 	clear();
 	int row, col;
 	getmaxyx(stdscr,row,col);  /* get the number of rows and columns */
 	/* print good bye message */
  	mvprintw(row/2,(col-strlen("Good bye. See you again!"))/2,"%s", 
  		"Good bye. See you again!");	
+	if (session_path[0] != '\0' && player->isFail1 == false && player->isFail2 == false) {  /* tell which game to resume */
+		mvprintw(row/2 + 1, (col-strlen("Resume: ./2048.sh --resume ")-strlen(session_path))/2,
+			"Resume: ./2048.sh --resume %s", session_path);
+	}
 	refresh();
 	sleep(1);  /* display for a while before exit */
 	exit(-1);
@@ -942,24 +948,32 @@ void *first_player_move(void* param) {
 
 void *hvh_player_move(void* param) {
 	struct player *player = (struct player*) param;
-	int *table1 = player->table1;
-	int *score1 = &(player->score1);
+	unsigned char *table1 = player->table1;
+	long long *score1 = &(player->score1);
 	bool *isStuck1 = &(player->isStuck1);
 	bool *isMatch1 = &(player->isMatch1);
 	int *y = &(player->y);
 	bool *isFail1 = &(player->isFail1);	
 	int *timer = &(player->timer);
-	int temp = *timer;
+	int temp = player->time_limit;
+	unsigned int *seed1 = &(player->seed1);
 
-	int *table2 = player->table2;
-	int *score2 = &(player->score2);
+	unsigned char *table2 = player->table2;
+	long long *score2 = &(player->score2);
 	bool *isStuck2 = &(player->isStuck2);
 	bool *isMatch2 = &(player->isMatch2);	
 	bool *isFail2 = &(player->isFail2);
+	unsigned int *seed2 = &(player->seed2);
 
-	reset_table(table1, y);  /* reset value of the table */
-	reset_table(table2, y);  /* reset value of the table */
-	init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);
+	if (player->resumed == true) {  /* continue the boards of the session */
+		player->resumed = false;
+		init_colors();
+		print_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);
+	} else {
+		reset_table(table1, y);  /* reset value of the table */
+		reset_table(table2, y);  /* reset value of the table */
+		init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer, seed1, seed2);
+	}
 
 	int key = '0';
 	while(key != 27 && key != 27) {  						
@@ -970,10 +984,10 @@ void *hvh_player_move(void* param) {
 				/* SECOND PLAYER'S MOVES */			
 				case KEY_DOWN:  /* press "DOWN" button */
 					if (*isFail1 == false && *isFail2 == false) {
-						down(table2, score2, isStuck2, isMatch2, y);					
+						moves->down(table2, score2, isStuck2, isMatch2, y);					
 
 						if (*isStuck2 == false || *isMatch2 == true) {
-							add_value(table2, isFail2, y);	/* print the table again */											
+							add_value(table2, isFail2, y, seed2);	/* print the table again */											
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -984,10 +998,10 @@ void *hvh_player_move(void* param) {
 					break;
 				case KEY_UP:  /* press "UP" button */
 					if (*isFail1 == false && *isFail2 == false) {
-						up(table2, score2, isStuck2, isMatch2, y);					
+						moves->up(table2, score2, isStuck2, isMatch2, y);					
 
 						if (*isStuck2 == false || *isMatch2 == true) {
-							add_value(table2, isFail2, y);	/* print the table again */											
+							add_value(table2, isFail2, y, seed2);	/* print the table again */											
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -998,10 +1012,10 @@ void *hvh_player_move(void* param) {
 					break;
 				case KEY_RIGHT:   // press "RIGHT" button 
 					if (*isFail1 == false && *isFail2 == false) {
-						right(table2, score2, isStuck2, isMatch2, y);					
+						moves->right(table2, score2, isStuck2, isMatch2, y);					
 
 						if (*isStuck2 == false || *isMatch2 == true) {
-							add_value(table2, isFail2, y);	/* print the table again */											
+							add_value(table2, isFail2, y, seed2);	/* print the table again */											
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -1012,10 +1026,10 @@ void *hvh_player_move(void* param) {
 					break;
 				case KEY_LEFT:  /* press "LEFT" button */
 					if (*isFail1 == false && *isFail2 == false) {
-						left(table2, score2, isStuck2, isMatch2, y);					
+						moves->left(table2, score2, isStuck2, isMatch2, y);					
 
 						if (*isStuck2 == false || *isMatch2 == true) {
-							add_value(table2, isFail2, y);	/* print the table again */											
+							add_value(table2, isFail2, y, seed2);	/* print the table again */											
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -1028,10 +1042,10 @@ void *hvh_player_move(void* param) {
 				/* FIRST PLAYER'S MOVES */
 				case 's':  /* press "DOWN" button */
 					if (*isFail1 == false && *isFail2 == false) {
-						down(table1, score1, isStuck1, isMatch1, y);										
+						moves->down(table1, score1, isStuck1, isMatch1, y);										
 
 						if (*isStuck1 == false || *isMatch1 == true) {							
-							add_value(table1, isFail1, y);	/* print the table again */							
+							add_value(table1, isFail1, y, seed1);	/* print the table again */							
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -1042,10 +1056,10 @@ void *hvh_player_move(void* param) {
 					break;
 				case 'w':  /* press "UP" button */
 					if (*isFail1 == false && *isFail2 == false) {
-						up(table1, score1, isStuck1, isMatch1, y);										
+						moves->up(table1, score1, isStuck1, isMatch1, y);										
 
 						if (*isStuck1 == false || *isMatch1 == true) {							
-							add_value(table1, isFail1, y);	/* print the table again */							
+							add_value(table1, isFail1, y, seed1);	/* print the table again */							
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -1056,10 +1070,10 @@ void *hvh_player_move(void* param) {
 					break;
 				case 'd':   // press "RIGHT" button 
 					if (*isFail1 == false && *isFail2 == false) {
-						right(table1, score1, isStuck1, isMatch1, y);										
+						moves->right(table1, score1, isStuck1, isMatch1, y);										
 
 						if (*isStuck1 == false || *isMatch1 == true) {							
-							add_value(table1, isFail1, y);	/* print the table again */							
+							add_value(table1, isFail1, y, seed1);	/* print the table again */							
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -1070,10 +1084,10 @@ void *hvh_player_move(void* param) {
 					break;
 				case 'a':  /* press "LEFT" button */
 					if (*isFail1 == false && *isFail2 == false) {
-						left(table1, score1, isStuck1, isMatch1, y);										
+						moves->left(table1, score1, isStuck1, isMatch1, y);										
 
 						if (*isStuck1 == false || *isMatch1 == true) {							
-							add_value(table1, isFail1, y);	/* print the table again */							
+							add_value(table1, isFail1, y, seed1);	/* print the table again */							
 						}					
 
 						/* clear all UI elements displayed on the terminal */
@@ -1090,9 +1104,9 @@ void *hvh_player_move(void* param) {
 					reset_table(table2, y);  /* reset value of the table */
 					clear();
 					if (temp == 11) {
-						init_table(table1, score1, isFail1, y);
+						init_table(table1, score1, isFail1, y, seed1);
 					} else {
-						init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);
+						init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer, seed1, seed2);
 					}
 					break;		
 				default:				
@@ -1100,8 +1114,8 @@ void *hvh_player_move(void* param) {
 			}		
 
 			/* check if there's any available move left for both players */
-			check_failing(table1, isFail1, y); 
-			check_failing(table2, isFail2, y);  
+			moves->check_failing(table1, isFail1, y); 
+			moves->check_failing(table2, isFail2, y);  
 		} else {  /* player fails */
 			clear(); 
 			/* Print table when fail */			
@@ -1119,21 +1133,25 @@ void *hvh_player_move(void* param) {
 					reset_table(table1, y);  
 					reset_table(table2, y);  
 					clear();					
-					init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);
+					init_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer, seed1, seed2);
 					break;			
 				}
 			}			
 		}				
 	}
 	
-	*isFail1 = true; *isFail2 = true;
-	free(table1); free(table2);
+	/* stop the other threads, the boards stay in the session file */
+	player->quit = true;
 	clear();
 	int row, col;
 	getmaxyx(stdscr,row,col);  /* get the number of rows and columns */
 	/* print good bye message */
  	mvprintw(row/2,(col-strlen("Good bye. See you again!"))/2,"%s", 
  		"Good bye. See you again!");	
+	if (session_path[0] != '\0' && player->isFail1 == false && player->isFail2 == false) {  /* tell which game to resume */
+		mvprintw(row/2 + 1, (col-strlen("Resume: ./2048.sh --resume ")-strlen(session_path))/2,
+			"Resume: ./2048.sh --resume %s", session_path);
+	}
 	refresh();
 	sleep(1);  /* display for a while before exit */
 	exit(-1);
@@ -1142,19 +1160,21 @@ void *hvh_player_move(void* param) {
 
 void *count_down(void* param) {
 	struct player *counter = (struct player*) param;
-	int *table1 = counter->table1;
-	int *score1 = &(counter->score1);
+	unsigned char *table1 = counter->table1;
+	long long *score1 = &(counter->score1);
 	int *y = &(counter->y);
 	bool *isFail1 = &(counter->isFail1);	
 	int *timer = &(counter->timer);
 
-	int *table2 = counter->table2;
-	int *score2 = &(counter->score2);
+	unsigned char *table2 = counter->table2;
+	long long *score2 = &(counter->score2);
 	bool *isFail2 = &(counter->isFail2);
 	
 	while(true) {		
 		sleep(1);			
-		if (*isFail1 == false && *isFail2 == false && *timer > 0) {
+		if (counter->quit == true) {  /* players are leaving the game */
+			continue;
+		} else if (*isFail1 == false && *isFail2 == false && *timer > 0) {
 			*timer = *timer - 1;
 			clear();
 			print_2_table(table1, score1, isFail1, table2, score2, isFail2, y, timer);	
@@ -1183,41 +1203,47 @@ void *medium_AI(void* param) {
 	int turn = 0; // Turn to perform variable action
 	int *y = &(mediumAI->y); // Length of column 			
 
-	int *table = mediumAI->table1; // The array containing numbers of table   
-	int *score = &(mediumAI->score1); // Score of the play		 
+	unsigned char *table = mediumAI->table1; // The array containing numbers of table   
+	long long *score = &(mediumAI->score1); // Score of the play		 
 	bool *isFail = &(mediumAI->isFail1); // Boolean to check if game is failed
 	bool *isStuck = &(mediumAI->isStuck1); // Boolean to check if there is slots to move
 	bool *isMatch = &(mediumAI->isMatch1); // Boolean to check if there is matching pairs
+	unsigned int *seed = &(mediumAI->seed1); // Random seed of the table
 	
-	int *table_clone = malloc((*y) * (*y) * sizeof(int)); // A copy of array containing numbers of table   
+	// A copy of array containing numbers of table, kept in the scratch memory of this thread
+	unsigned char *table_clone = arena_alloc(arena_get(), (*y) * (*y));
+	if (table_clone == NULL) {
+		*isFail = true;  // No memory to think with, the AI loses the game
+		pthread_exit(NULL);
+	}
 
 	sleep(1);
 	while (true) {
 		//Check if any player is failed
-		if ((mediumAI->isFail1) == false && (mediumAI->isFail2) == false) {						
+		if ((mediumAI->isFail1) == false && (mediumAI->isFail2) == false && (mediumAI->quit) == false) {						
 			
 			//Copy the array of table into the clone 
-			memcpy(table_clone, table, (*y) * (*y) * sizeof(int));
+			memcpy(table_clone, table, (*y) * (*y));
 
 			if (turn == 0) { //Turn 0, move up
-				up(table, score, isStuck, isMatch, y);
+				moves->up(table, score, isStuck, isMatch, y);
 				turn = 1;			
 			} else if (turn == 1) { //Turn 1, move left
-				left(table, score, isStuck, isMatch, y);
+				moves->left(table, score, isStuck, isMatch, y);
 				turn = 0;
 			}
 
 			//If the table is stuck (nothing is move) after first try, move right 
 			if (check_stuck(table, table_clone, (*y) * (*y)) == true) {
-				right(table, score, isStuck, isMatch, y);
+				moves->right(table, score, isStuck, isMatch, y);
 			}
 
 			//If the table is stuck (nothing is move) after second try, move down 
 			if (check_stuck(table, table_clone, (*y) * (*y)) == true) {
-				down(table, score, isStuck, isMatch, y);
+				moves->down(table, score, isStuck, isMatch, y);
 			} 
 
-			check_failing(table, isFail, y);  // check if there's any available move left on the board.
+			moves->check_failing(table, isFail, y);  // check if there's any available move left on the board.
 
 			if ((mediumAI->inp) == 231 && (*isFail == true)) {
 				print_2_table(table, score, isFail, 
@@ -1225,7 +1251,7 @@ void *medium_AI(void* param) {
 			}
 
 			if (*isStuck == false || *isMatch == true) {
-				add_value(table, isFail, y); //	Add new random value											
+				add_value(table, isFail, y, seed); //	Add new random value											
 										
 				clear(); // clear all UI elements displayed on the terminal
 				sleep(1);
@@ -1236,47 +1262,109 @@ void *medium_AI(void* param) {
 		} 		
 	}	
 
-	free(table);
-	free(table_clone); 	
-	pthread_exit(NULL);
+	pthread_exit(NULL);  // the table belongs to the session, the clone to the thread's arena
+}
+
+void *mcts_AI(void* param) {
+	/*This AI can replace the medium AI in AI vs AI mode, it is displayed in the left table
+	 *Worker threads on all cores grow a Monte Carlo search tree for 1 second per move
+	 *The part of the tree below the new board is kept for the next move
+	 */
+
+	struct player *mctsAI = (struct player*) param;	
+
+	int *y = &(mctsAI->y); // Length of column 			
+
+	unsigned char *table = mctsAI->table1; // The array containing numbers of table   
+	long long *score = &(mctsAI->score1); // Score of the play		 
+	bool *isFail = &(mctsAI->isFail1); // Boolean to check if game is failed
+	bool *isStuck = &(mctsAI->isStuck1); // Boolean to check if there is slots to move
+	bool *isMatch = &(mctsAI->isMatch1); // Boolean to check if there is matching pairs
+	unsigned int *seed = &(mctsAI->seed1); // Random seed of the table
+
+	struct mcts *tree = mcts_start(sysconf(_SC_NPROCESSORS_ONLN), 1000, *seed);
+	
+	sleep(1);
+	while (true) {
+		//Check if any player is failed
+		if ((mctsAI->isFail1) == false && (mctsAI->isFail2) == false && (mctsAI->quit) == false) {						
+			//Think for 1 second, this replaces the wait between 2 moves
+			int dir = (tree != NULL) ? mcts_choose(tree, table, *y, NULL) : -1;
+			if (dir < 0) {
+				dir = MOVE_DOWN; // No tree or nothing moves, check_failing ends the game
+			}
+			*isStuck = !move_table(moves, dir, table, score, y);
+			*isMatch = false;
+
+			moves->check_failing(table, isFail, y);  // check if there's any available move left on the board.
+
+			if ((mctsAI->inp) == 231 && (*isFail == true)) {
+				print_2_table(table, score, isFail, 
+				mctsAI->table2, &(mctsAI->score2), &(mctsAI->isFail2), y, &(mctsAI->timer));		
+			}
+
+			if (*isStuck == false) {
+				add_value(table, isFail, y, seed); //	Add new random value											
+				clear(); // clear all UI elements displayed on the terminal
+			}
+		} else {
+			usleep(100000); // Wait for the restart or the end of the game
+		}
+	}	
+
+	pthread_exit(NULL);  // the table belongs to the session
 }
 
 void *smart_AI(void* param) {		
 	/*This AI can be used in both single mode and 2 player mode
 	 *This AI is displayed in the rigth table in 2 player mode 	  		
 	 *The strategy is to find the best move in 1 turn and move base on the result  
+	 *Each result is scored by the evaluation, its weights are read from eval.conf
+	 *If ntuple.q.weights or ntuple.weights holds a trained network of this board size, it scores the results instead
+	 *In 1-player Monte Carlo mode (13) each move is chosen by random games played on all cores instead
+	 *In AI vs AI mode the expectimax search looks 2 moves ahead, over every new number
 	 */
 
 	struct player *mediumAI = (struct player*) param;	
 
 	int *y = &(mediumAI->y); // Length of column	
 	int temp_choice = (mediumAI->inp); // The game choice
-	int temp_time = (mediumAI->timer); 	
+	bool solo = (temp_choice == 12) || (temp_choice == 13); // 1-player mode
+	int temp_time = (mediumAI->time_limit); 	
 	//int temp_choice = *inp;
 	 
-   	int *table; // The array containing numbers of table   
-	int *score; // Score of the play		 
+   	unsigned char *table; // The array containing numbers of table   
+	long long *score; // Score of the play		 
 	bool *isFail; // Boolean to check if game is failed
 	bool *isStuck; // Boolean to check if there is slots to move
 	bool *isMatch; // Boolean to check if there is matching pairs
+	unsigned int *seed; // Random seed of the table
 
 	//The below value is used to calculate the best move
-	int score_clone; // A copy of score
+	long long score_clone; // A copy of score
 	bool isStuck_clone; // A copy of boolean isStruck
 	bool isMatch_clone; // A copy of boolean isMatch
-   	int *table_clone = malloc((*y) * (*y) * sizeof(int)); // A copy of array containing numbers of table   	 
+	// A copy of array containing numbers of table, kept in the scratch memory of this thread
+   	unsigned char *table_clone = arena_alloc(arena_get(), (*y) * (*y));
 
-	if (temp_choice == 12) { //If player choose 1-player mode
+	if (solo == true) { //If player choose 1-player mode
 		//Get value of the left table		
 		table = mediumAI->table1;
 		score = &(mediumAI->score1);		
 		isFail = &(mediumAI->isFail1);
 		isStuck = &(mediumAI->isStuck1);
 		isMatch = &(mediumAI->isMatch1);
+		seed = &(mediumAI->seed1);
 
-		reset_table(mediumAI->table1, y);  
-		reset_table(mediumAI->table2, y);
-		init_table(table, score, isFail, y);
+		if (mediumAI->resumed == true) {  //Continue the table of the session
+			mediumAI->resumed = false;
+			init_colors();
+			print_table(table, score, isFail, y);
+		} else {
+			reset_table(mediumAI->table1, y);  
+			reset_table(mediumAI->table2, y);
+			init_table(table, score, isFail, y, seed);
+		}
 
 	} else { //If player choose 2-player mode
 		//Get value of the right table
@@ -1285,31 +1373,74 @@ void *smart_AI(void* param) {
 		isFail = &(mediumAI->isFail2);
 		isStuck = &(mediumAI->isStuck2);
 		isMatch = &(mediumAI->isMatch2);
-
-		if ((temp_choice == 232) || (temp_choice == 231)) {			
+		seed = &(mediumAI->seed2);
+
+		if (((temp_choice == 232) || (temp_choice == 231)) && (mediumAI->resumed == true)) {
+			//Continue the tables of the session
+			mediumAI->resumed = false;
+			init_colors();
+			print_2_table(mediumAI->table1, &(mediumAI->score1), &(mediumAI->isFail1), 
+				table, score, isFail, y, &(mediumAI->timer));
+		} else if ((temp_choice == 232) || (temp_choice == 231)) {			
 			reset_table(mediumAI->table1, y);  
 			reset_table(mediumAI->table2, y);
 			init_2_table(mediumAI->table1, &(mediumAI->score1), &(mediumAI->isFail1), 
-				 table, score, isFail, y, &(mediumAI->timer));		
+				 table, score, isFail, y, &(mediumAI->timer), &(mediumAI->seed1), seed);		
 		}		
 	}
+	if (table_clone == NULL) {
+		*isFail = true;  // No memory to think with, the AI loses the game
+		pthread_exit(NULL);
+	}
+
+	//Precompute the evaluation of this board size
+	struct weights weights;
+	struct evaluator evaluator;
+	eval_default_weights(&weights);
+	eval_load_weights(EVAL_FILE, &weights);
+	eval_init(&evaluator, *y, &weights);
+
+	//Map the trained n-tuple network, it is shared with every other game running
+	//The quantized weights are smaller and faster, they are used when they exist
+	struct ntuple network;
+	bool use_network = false;
+	const char *networks[2] = {NTUPLE_QUANTIZED_FILE, NTUPLE_FILE};
+	for (int i = 0; i < 2 && use_network == false; i++) {
+		use_network = ntuple_open(&network, networks[i], false);
+		if (use_network == true && network.y != *y) {
+			ntuple_close(&network);
+			use_network = false;
+		}
+	}
+
+	//Prepare the expectimax search, it scores boards like the 1-move strategy
+	struct search search;
+	search_init(&search, *y, &evaluator, use_network ? &network : NULL);
+	search.cutoff = mediumAI->cutoff;
+
+	//Start the threads playing the random games of the Monte Carlo mode, they think 1 second per move
+	struct rollout_pool *pool = NULL;
+	struct rollout_report report = {0, 0, false};
+	if (temp_choice == 13) {
+		pool = rollout_start(sysconf(_SC_NPROCESSORS_ONLN), 1000, *seed);
+	}
 
 	//Copy the value to the clone
 	score_clone = *score;
 	isStuck_clone = *isStuck;
 	isMatch_clone = *isMatch;
-   	memcpy(table_clone, table, (*y) * (*y) * sizeof(int));
+   	memcpy(table_clone, table, (*y) * (*y));
 
 	sleep(1);
 	while (true) {			
 		//Check if any player is failed
-		if ((mediumAI->isFail1) == false && (mediumAI->isFail2) == false) {
+		if ((mediumAI->isFail1) == false && (mediumAI->isFail2) == false && (mediumAI->quit) == false) {
 
 			//Array containing the "predicted score" after moving each direction
-			int predict_score[4] = {0,0,0,0};
+			float predict_score[4] = {0,0,0,0};
 
 			//Array containing adresses of function
-			void (* sort_funcs[4])(int*, int*, bool*, bool*, int*) = {&down, &up, &left, &right};
+			void (* sort_funcs[4])(unsigned char*, long long*, bool*, bool*, int*) = {moves->down, moves->up, moves->left, moves->right};
 
 			//Move in each direction to find out the best move
 			for (int i = 0; i < 4; i++) {				
@@ -1317,11 +1448,14 @@ void *smart_AI(void* param) {
 				//Moving using clone values
 				(* sort_funcs[i])(table_clone, &score_clone, &isStuck_clone, &isMatch_clone, y);	
   
-				predict_score[i] = score_clone; // Get the score after the move
-				predict_score[i] += check_matchingPair(table_clone, y); // Get the number of matching pairs
-				for (int j = 0; j < (*y) * (*y); j++) { 
-					if (table_clone[j] == 0) {
-						predict_score[i] += 1; //Get the number of free space
+				if (isStuck_clone == true) {
+					predict_score[i] = -FLT_MAX; // Nothing moves, never choose it
+				} else {
+					predict_score[i] = score_clone - *score; // Get the score of the move
+					if (use_network == true) { // Score the board after the move
+						predict_score[i] += ntuple_eval(&network, table_clone);
+					} else {
+						predict_score[i] += eval_board(&evaluator, table_clone);
 					}
 				}
 
@@ -1329,12 +1463,12 @@ void *smart_AI(void* param) {
 				score_clone = *score;
 				isStuck_clone = *isStuck;
 				isMatch_clone = *isMatch;
-			   	memcpy(table_clone, table, (*y) * (*y) * sizeof(int));						
+			   	memcpy(table_clone, table, (*y) * (*y));						
 			}
 
 			//Find the index of best move in function arrays 
 			int index = 0;		
-			int largest = predict_score[0];			
+			float largest = predict_score[0];			
 
 			for (int i = 0; i < 4; i++) {
 				if (largest < predict_score[i]) {
@@ -1343,6 +1477,22 @@ void *smart_AI(void* param) {
 				}
 			}
 
+			//In AI vs AI mode the expectimax search chooses the move
+			if ((temp_choice == 231) || (temp_choice == 232)) {
+				int dir = search_best(&search, table, 2, NULL);
+				if (dir >= 0) {
+					index = dir;
+				}
+			}
+
+			//In Monte Carlo mode the random games choose the move instead
+			if (pool != NULL) {
+				int dir = rollout_choose(pool, table, *y, &report);
+				if (dir >= 0) {
+					index = dir;
+				}
+			}
+
 			//Move the table base on the best move, actual value is use
 			(* sort_funcs[index])(table, score, isStuck, isMatch, y);
 
@@ -1362,30 +1512,37 @@ void *smart_AI(void* param) {
 
 			}
 			
-			check_failing(table, isFail, y); // check if there's any available move left on the board.				
+			moves->check_failing(table, isFail, y); // check if there's any available move left on the board.				
 
 			if (*isStuck == false || *isMatch == true) {
-				add_value(table, isFail, y); //	Add new random value											
+				add_value(table, isFail, y, seed); //	Add new random value											
 										
 				clear(); // clear all UI elements displayed on the terminal  	
 
 				/* print the table again */ 
-				if (temp_choice == 12) {
+				if (solo == true) {
 					print_table(table, score, isFail, y);
+					if (pool != NULL) {
+						printw("\n\n%ld random games in %.0f ms%s", report.rollouts, report.ms,
+							report.early ? " (the best move was clear)" : "");
+						refresh();
+					}
 				} else {
-					if ((temp_choice == 231) || (temp_choice == 2221))  {
+					if (temp_choice == 231) {
 						print_2_table(mediumAI->table1, &(mediumAI->score1), &(mediumAI->isFail1), 
 							  table, score, isFail, y, &(mediumAI->timer));		
 					}					
 				}
 
-				sleep(1);
+				if (report.ms < 1000) { //The Monte Carlo mode already spent its thinking time
+					usleep((1000 - report.ms) * 1000);
+				}
 								
 			} else {
 				continue;
 			}									
 		} else {
-			if ((temp_choice == 12) || (temp_choice == 231) || (temp_choice == 232)) {
+			if ((solo == true) || (temp_choice == 231) || (temp_choice == 232)) {
 				int key = 0;
 				while(true) {
 					clear();
@@ -1403,11 +1560,11 @@ void *smart_AI(void* param) {
 						reset_table(mediumAI->table2, y);  /* reset value of the table */
 						clear();
 
-						if (temp_choice == 12) {
-							init_table(table, score, isFail, y);
+						if (solo == true) {
+							init_table(table, score, isFail, y, seed);
 						} else {
 							init_2_table(mediumAI->table1, &(mediumAI->score1), &(mediumAI->isFail1), 
-				 						table, score, isFail, y, &(mediumAI->timer));
+				 						table, score, isFail, y, &(mediumAI->timer), &(mediumAI->seed1), seed);
 						}
 						 	
 						break;		
@@ -1420,8 +1577,14 @@ void *smart_AI(void* param) {
 					 		"Good bye. See you again!");	
 						refresh();
 						sleep(1);  /* display for a while before exit */					
-						free(table);
-						free(table_clone);
+						eval_free(&evaluator);
+						search_free(&search);
+						if (pool != NULL) {
+							rollout_stop(pool);
+						}
+						if (use_network == true) {
+							ntuple_close(&network);
+						}
 						exit(-1);
 						pthread_exit(NULL);
 					}	
@@ -1437,7 +1600,7 @@ void *smart_AI(void* param) {
 	}		
 }
 
-bool check_stuck(int *table, int *table_clone, int length) {
+bool check_stuck(unsigned char *table, unsigned char *table_clone, int length) {
 	bool stuck = true; // Boolean to check if the table is stuck
 
 	//If the value of table is the same as the clone, the table is stuck
@@ -1450,133 +1613,3 @@ bool check_stuck(int *table, int *table_clone, int length) {
 
 	return stuck;
 }
-
-int check_matchingPair(int *table_clone, int *y) {
-	//Find the matching pairs available in the table
-
-	int matchingPair = 0;// Intger to store number of pairs
-
-	/* start from the bottom of table */
-	for (int i = (*y * *y) - 1; i > (*y * *y) - (*y + 1); --i)	{  
-		for (int j = 0; j < (*y * *y) - (*y - 1);) {					
-			int temp = table_clone[i - j];
-
-			if (temp != 0) {  /* if the key value is not 0 */
-				bool check = false;
-
-				for (int k = j + *y; k < (*y * *y) - (*y - 1); k += *y)	{  /* search through other rows of a column */
-					if (table_clone[i - k] == temp) {  /* if the 2 values are match */
-						matchingPair++;													
-						break;																						
-
-						// if there is a different number 
-						// in front of the key value 							 
-					} else if (table_clone[i - k] != temp && table_clone[i - k] != 0) {  
-						break;
-					}
-				}
-
-				// if there's no matching value with the key value 
-				// in the same column					 
-				if (check == false) {  
-					j += *y;  /* change key value to the next row of a column */
-				}
-			} else {
-				j += *y;  /* change key value to the next row of a column */
-			}					
-		}					
-	}
-
-	/* start from the top of table */
-	for (int i = 0; i < *y; ++i)	{  
-		for (int j = 0; j < (*y * *y) - (*y - 1);)	{					
-			int temp = table_clone[i + j];
-
-			if (temp != 0) {  /* if the key value is not 0 */
-				bool check = false;
-
-				/* search through other rows of a column */
-				for (int k = j + *y; k < (*y * *y) - (*y - 1); k += *y)	{  
-					if (table_clone[i + k] == temp) {  /* if the 2 values are match */
-						matchingPair++;
-
-						// if there is a different number 
-						// in front of the key value 							
-					} else if (table_clone[i + k] != temp && table_clone[i + k] != 0) {
-						break;
-					}
-				}
-
-				// if there's no matching value with the key value 
-				// in the same column					
-				if (check == false) {
-					j += *y;  /* change key value to the next row of a column */
-				}
-			} else {
-				j += *y;  /* change key value to the next row of a column */
-			}					
-		}					
-	}
-
-	/* start from the left of table */
-	for (int i = *y - 1; i < (*y * *y); i += *y)	{  
-		for (int j = 0; j < *y;)	{					
-			int temp = table_clone[i - j];
-
-			if (temp != 0) {  /* if the key value is not 0 */
-				bool check = false;
-
-				for (int k = j + 1; k < *y; ++k)	{  /* search through other columns of a row */
-					if (table_clone[i - k] == temp) {  /* if the 2 values are match */
-						matchingPair++;																						
-
-						// if there is a different number 
-						// in front of the key value 							
-					} else if (table_clone[i - k] != temp && table_clone[i - k] != 0) {  
-						break;
-					}
-				}
-
-				// if there's no matching value with the key value 
-				// in the same column					
-				if (check == false) {  
-					j++;  /* change key value to the next column of a row */
-				}
-			} else {
-				j++;  /* change key value to the next column of a row */
-			}					
-		}					
-	}
-
-	/* start from the right of table */
-	for (int i = 0; i < (*y * *y) - (*y - 1); i += *y)	{  
-		for (int j = 0; j < *y;)	{					
-			int temp = table_clone[i + j];
-
-			if (temp != 0) {  /* if the key value is not 0 */
-				bool check = false;
-
-				for (int k = j + 1; k < *y; ++k)	{  /* search through other rows of a column */
-					if (table_clone[i + k] == temp) {  /* if the 2 values are match */
-						matchingPair++;
-
-						// if there is a different number 
-						// in front of the key value 							
-					} else if (table_clone[i + k] != temp && table_clone[i + k] != 0) {
-						break;
-					}
-				}
-
-				// if there's no matching value with the key value 
-				// in the same column					
-				if (check == false) {
-					j++;  /* change key value to the next row of a column */
-				}
-			} else {
-				j++;  /* change key value to the next row of a column */
-			}					
-		}
-	}
-
-	return matchingPair;
-}
@@ -0,0 +1,236 @@
+/** @file ai.c
+ * @brief This file contains the policies that choose the moves
+ * of the AI without the user interface, and the AI driver whose
+ * difficulty levels only differ by evaluation and search budget.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
+#include "key_algorithm.h"
+#include "eval.h"
+#include "ntuple.h"
+#include "rollout.h"
+#include "mcts.h"
+#include "search.h"
+#include "rng.h"
+#include "ai.h"
+
+/* from random moves to a deep search, each searching level may use 30 times more nodes than
+ * the one below (mean scores on 4x4: about 1000, 2400, 3700, 18000, 39000 and 68000) */
+const struct ai_level ai_levels[AI_LEVELS] = {
+	{"Beginner", AI_RANDOM, 0},  /* any move that moves something */
+	{"Novice", AI_SCORE, 1},  /* the move making the most points */
+	{"Easy", AI_BOARD, 1},  /* the move leaving the best board */
+	{"Medium", AI_BOARD, 100},
+	{"Hard", AI_BOARD, 3000},
+	{"Expert", AI_NETWORK, 100000}
+};
+
+/** @struct AI of one level playing one board size.
+ */
+struct ai_player {
+	struct ai_level level; struct rng_stream stream; long moves;  /* moves: chosen so far, the counter of its draws */
+	struct evaluator evaluator; bool use_evaluator; struct ntuple network; bool use_network;
+	struct search search;
+};
+
+/** @brief Choose the move whose score plus evaluation of the
+ * resulting board is the highest (the strategy of smart_AI).
+ * @param evaluator the evaluator of the board size (struct evaluator)
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction, -1 if nothing can move
+ */
+int ai_greedy(void *evaluator, const unsigned char *a, int y) {
+	const struct moves *moves = get_moves(y);
+	float largest = -FLT_MAX;
+	int index = -1;
+
+	for (int dir = 0; dir < 4; ++dir) {
+		unsigned char clone[MAX_LENGTH * MAX_LENGTH];
+		long long score = 0;
+		memcpy(clone, a, y * y);
+
+		if (move_table(moves, dir, clone, &score, &y) == true) {
+			float predict = score + eval_board(evaluator, clone);
+			if (predict > largest) {
+				largest = predict;
+				index = dir;
+			}
+		}
+	}
+	return index;
+}
+
+/** @brief Choose the move whose score plus value of the resulting
+ * board in the n-tuple network is the highest.
+ * @param network the n-tuple network of the board size (struct ntuple)
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction, -1 if nothing can move
+ */
+int ai_ntuple(void *network, const unsigned char *a, int y) {
+	const struct moves *moves = get_moves(y);
+	float largest = -FLT_MAX;
+	int index = -1;
+
+	for (int dir = 0; dir < 4; ++dir) {
+		unsigned char clone[MAX_LENGTH * MAX_LENGTH];
+		long long score = 0;
+		memcpy(clone, a, y * y);
+
+		if (move_table(moves, dir, clone, &score, &y) == true) {
+			float predict = score + ntuple_eval(network, clone);
+			if (predict > largest) {
+				largest = predict;
+				index = dir;
+			}
+		}
+	}
+	return index;
+}
+
+/** @brief Choose the move with the best mean score of random games
+ * played after it, within the time budget of the pool.
+ * @param pool the worker threads (struct rollout_pool)
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction, -1 if nothing can move
+ */
+int ai_rollout(void *pool, const unsigned char *a, int y) {
+	return rollout_choose(pool, a, y, NULL);
+}
+
+/** @brief Choose the move most visited by the Monte Carlo tree search,
+ * within the time budget of the tree.
+ * @param tree the tree (struct mcts)
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction, -1 if nothing can move
+ */
+int ai_mcts(void *tree, const unsigned char *a, int y) {
+	return mcts_choose(tree, a, y, NULL);
+}
+
+/** @brief Choose the move of medium_AI: up and left in turn to keep the
+ * big numbers in the top row, right if that does not move, then down,
+ * and the other turn on its next try when nothing of these moves.
+ * @param turn the turn of the AI (int, 0 to move up next), updated
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction, -1 if nothing can move
+ */
+int ai_corner(void *turn, const unsigned char *a, int y) {
+	const struct moves *moves = get_moves(y);
+	int *next = turn;
+	int order[4] = {*next == 0 ? MOVE_UP : MOVE_LEFT, MOVE_RIGHT, MOVE_DOWN, *next == 0 ? MOVE_LEFT : MOVE_UP};
+
+	for (int i = 0; i < 4; ++i) {
+		unsigned char clone[MAX_LENGTH * MAX_LENGTH];
+		long long score = 0;
+		memcpy(clone, a, y * y);
+		if (move_table(moves, order[i], clone, &score, &y) == true) {
+			*next = (*next + (i < 3)) % 2;  /* the turn after the other turn is the same one */
+			return order[i];
+		}
+	}
+	return -1;
+}
+
+/** @brief Prepare the AI of a level: load the evaluation it needs and
+ * the trained network of the board size if the level uses it.
+ * @param y colum length of game board
+ * @param level index of the level in ai_levels
+ * @param cutoff chance below which the search does not look further
+ * @param stream random numbers of the game, for the moves of the Beginner level
+ * @return the AI, NULL if there is no memory
+ */
+struct ai_player *ai_player_start(int y, int level, float cutoff, const struct rng_stream *stream) {
+	struct ai_player *p = calloc(1, sizeof(struct ai_player));
+	if (p == NULL) {
+		return NULL;
+	}
+	if (level < 0 || level >= AI_LEVELS) {
+		level = 0;
+	}
+	p->level = ai_levels[level];
+	p->stream = *stream;
+
+	if (p->level.eval == AI_NETWORK) {  /* the quantized weights are smaller and faster */
+		const char *networks[2] = {NTUPLE_QUANTIZED_FILE, NTUPLE_FILE};
+		for (int i = 0; i < 2 && p->use_network == false; i++) {
+			p->use_network = ntuple_open(&p->network, networks[i], false);
+			if (p->use_network == true && p->network.y != y) {
+				ntuple_close(&p->network);
+				p->use_network = false;
+			}
+		}
+	}
+	if (p->level.eval >= AI_BOARD && p->use_network == false) {
+		struct weights weights;
+		eval_default_weights(&weights);
+		eval_load_weights(EVAL_FILE, &weights);
+		p->use_evaluator = eval_init(&p->evaluator, y, &weights);
+	}
+
+	search_init(&p->search, y, p->use_evaluator ? &p->evaluator : NULL, p->use_network ? &p->network : NULL);
+	p->search.cutoff = cutoff;
+	return p;
+}
+
+/** @brief Choose a move with the evaluation and the nodes of the level.
+ * @param p the AI
+ * @param a the exponents of the game board
+ * @param budget_ms time limit of the move in milliseconds, 0 for none
+ * @param report the depth reached, the nodes and the time, can be NULL
+ * @return the direction, -1 if nothing can move
+ */
+int ai_player_choose(struct ai_player *p, const unsigned char *a, int budget_ms, struct search_report *report) {
+	if (p->level.eval != AI_RANDOM) {
+		return search_deadline(&p->search, a, budget_ms, p->level.nodes, report);
+	}
+
+	int y = p->search.y, legal[4], count = 0;
+	for (int dir = 0; dir < 4; ++dir) {
+		unsigned char clone[MAX_LENGTH * MAX_LENGTH];
+		long long score = 0;
+		memcpy(clone, a, y * y);
+		if (move_table(p->search.moves, dir, clone, &score, &y) == true) {
+			legal[count++] = dir;
+		}
+	}
+	if (report != NULL) {
+		memset(report, 0, sizeof(*report));
+	}
+	uint32_t r[4];
+	rng_draw(&p->stream, p->moves++, RNG_AI, r);
+	return count > 0 ? legal[rng_below(r[0], count)] : -1;
+}
+
+/** @brief Free an AI.
+ * @param p the AI
+ * @return none
+ */
+void ai_player_stop(struct ai_player *p) {
+	search_free(&p->search);
+	if (p->use_network == true) {
+		ntuple_close(&p->network);
+	}
+	if (p->use_evaluator == true) {
+		eval_free(&p->evaluator);
+	}
+	free(p);
+}
+
+/** @brief Choose a move with an AI level, without a time limit.
+ * @param player the AI (struct ai_player)
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction, -1 if nothing can move
+ */
+int ai_driver(void *player, const unsigned char *a, int y) {
+	return ai_player_choose(player, a, 0, NULL);
+}
@@ -0,0 +1,27 @@
+#define AI_LEVELS 6
+
+/* how an AI level scores the boards */
+enum { AI_RANDOM, AI_SCORE, AI_BOARD, AI_NETWORK };
+
+/** @struct Difficulty level of the AI: the evaluation it uses and the
+ * nodes it may search per move, so its CPU cost is known in advance.
+ */
+struct ai_level {
+	const char *name; int eval; long nodes;  /* AI_NETWORK uses AI_BOARD without a trained network */
+};
+
+extern const struct ai_level ai_levels[AI_LEVELS];
+
+struct ai_player;
+struct search_report;
+struct rng_stream;
+
+int ai_greedy(void *evaluator, const unsigned char *a, int y);
+int ai_ntuple(void *network, const unsigned char *a, int y);
+int ai_rollout(void *pool, const unsigned char *a, int y);
+int ai_mcts(void *tree, const unsigned char *a, int y);
+int ai_corner(void *turn, const unsigned char *a, int y);
+struct ai_player *ai_player_start(int y, int level, float cutoff, const struct rng_stream *stream);
+int ai_player_choose(struct ai_player *p, const unsigned char *a, int budget_ms, struct search_report *report);
+void ai_player_stop(struct ai_player *p);
+int ai_driver(void *player, const unsigned char *a, int y);
@@ -0,0 +1,72 @@
+/** @file arena.c
+ * @brief This file gives every AI thread its own scratch memory
+ * for its clone boards, so deciding a move never calls malloc() or free().
+ *
+ * Ownership: the arena belongs to the thread that first calls arena_get().
+ * Only that thread uses it, and it is freed automatically when the thread
+ * exits, so threads can be started and stopped again without leaks.
+ * Blocks must never be freed one by one.
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "arena.h"
+
+static pthread_key_t arena_key;
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+
+/** @brief Free the arena of a thread that exits.
+ * @param param the arena
+ * @return none
+ */
+static void arena_destroy(void *param) {
+	struct arena *arena = param;
+	free(arena->memory);
+	free(arena);
+}
+
+/** @brief Create the key holding the arena of each thread.
+ * @return none
+ */
+static void arena_init_key() {
+	pthread_key_create(&arena_key, arena_destroy);
+}
+
+/** @brief Get the arena of the calling thread, it is created on the first call.
+ * @return the arena, NULL if there is no memory
+ */
+struct arena *arena_get() {
+	pthread_once(&arena_once, arena_init_key);
+
+	struct arena *arena = pthread_getspecific(arena_key);
+	if (arena == NULL) {
+		arena = malloc(sizeof(struct arena));
+		if (arena == NULL) {
+			return NULL;
+		}
+		arena->memory = aligned_alloc(ARENA_ALIGN, ARENA_SIZE);
+		arena->used = 0;
+		if (arena->memory == NULL) {
+			free(arena);
+			return NULL;
+		}
+		pthread_setspecific(arena_key, arena);
+	}
+	return arena;
+}
+
+/** @brief Take an aligned block from the arena.
+ * @param arena the arena of the calling thread, NULL if arena_get() failed
+ * @param size number of bytes
+ * @return the block, NULL if there is no arena or it is full
+ */
+void *arena_alloc(struct arena *arena, size_t size) {
+	size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+	if (arena == NULL || arena->used + size > ARENA_SIZE) {
+		return NULL;
+	}
+
+	void *block = arena->memory + arena->used;
+	arena->used += size;
+	return block;
+}
@@ -0,0 +1,14 @@
+#include <stddef.h>
+
+#define ARENA_SIZE (1024 * 1024)  /* scratch memory of one thread */
+#define ARENA_ALIGN 64  /* every block starts on its own cache line */
+
+/** @struct Scratch memory owned by one thread. Blocks are handed out
+ * one after the other and given back all at once when the thread exits.
+ */
+struct arena {
+	unsigned char *memory; size_t used;
+};
+
+struct arena *arena_get();
+void *arena_alloc(struct arena *arena, size_t size);
@@ -0,0 +1,72 @@
+/** @file bench.c
+ * @brief This program measures how fast the moves run
+ * and how much memory a game board needs for every board size.
+ * Usage: ./bench [seconds per size]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include "key_algorithm.h"
+
+/** @brief Get the current time in seconds.
+ * @return double
+ */
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Main function: play random games on every board size.
+ * @param argc number of arguments
+ * @param argv seconds spent on each board size (default 1)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+
+	printf("%4s %14s %10s %12s %14s\n", "size", "moves/sec", "games", "moves/game", "bytes/board");
+	for (int y = 3; y <= MAX_LENGTH; ++y) {
+		const struct moves *moves = get_moves(y);
+		void (*dir[4])(unsigned char*, long long*, bool*, bool*, int*) = {moves->down, moves->up, moves->left, moves->right};
+		unsigned char *table = calloc(y * y, sizeof(*table));
+		unsigned int seed = y;
+		long count = 0;
+		long games = 0;
+		long long score = 0;
+		bool isStuck, isMatch, isFail = false;
+
+		add_value(table, &isFail, &y, &seed);
+		double start = now();
+		double elapsed = 0;
+		while (elapsed < seconds) {
+			for (int i = 0; i < 4096; ++i) {  /* check the clock once in a while */
+				dir[rand_r(&seed) % 4](table, &score, &isStuck, &isMatch, &y);
+				count++;
+				if (isStuck == false) {
+					add_value(table, &isFail, &y, &seed);
+				}
+
+				moves->check_failing(table, &isFail, &y);
+				if (isFail == true) {  /* start a new game */
+					for (int j = 0; j < y * y; ++j) {
+						table[j] = 0;
+					}
+					score = 0;
+					isFail = false;
+					add_value(table, &isFail, &y, &seed);
+					games++;
+				}
+			}
+			elapsed = now() - start;
+		}
+
+		printf("%2dx%d %14.0f %10ld %12.1f %14zu\n", y, y, count / elapsed, games,
+			games > 0 ? (double) count / games : 0.0, y * y * sizeof(*table));
+		free(table);
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+/** @file canonical.c
+ * @brief This file contains the keys of the boards for the caches. A board
+ * and its 8 rotations and reflections play the same, so they get the same
+ * key: the smallest of the 8. A 4 x 4 board is packed in 64 bits (4 bits
+ * per slot, row 0 in the low 16 bits) and turned with a few masks and
+ * shifts; the other sizes use the smallest hash of the 8 boards.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "key_algorithm.h"
+#include "canonical.h"
+
+/** @brief Pack a 4 x 4 board, every exponent must be below 16.
+ * @param a the exponents of the game board
+ * @return the packed board, slot (r, c) in bits 16r + 4c to 16r + 4c + 3
+ */
+uint64_t board_pack(const unsigned char *a) {
+	uint64_t b = 0;
+	for (int i = 0; i < 16; ++i) {
+		b |= (uint64_t) a[i] << (4 * i);
+	}
+	return b;
+}
+
+/** @brief Swap the rows and the columns of a packed board.
+ * @param b the packed board
+ * @return uint64_t
+ */
+uint64_t pack_transpose(uint64_t b) {
+	/* swap the 4 bit slots inside each 2 x 2 block, then the 2 x 2 blocks */
+	uint64_t a = (b & 0xF0F00F0FF0F00F0FULL) | ((b & 0x0000F0F00000F0F0ULL) << 12)
+		| ((b & 0x0F0F00000F0F0000ULL) >> 12);
+	return (a & 0xFF00FF0000FF00FFULL) | ((a & 0x00FF00FF00000000ULL) >> 24)
+		| ((a & 0x00000000FF00FF00ULL) << 24);
+}
+
+/** @brief Mirror a packed board left to right.
+ * @param b the packed board
+ * @return uint64_t
+ */
+uint64_t pack_mirror(uint64_t b) {
+	return ((b & 0x000F000F000F000FULL) << 12) | ((b & 0x00F000F000F000F0ULL) << 4)
+		| ((b & 0x0F000F000F000F00ULL) >> 4) | ((b & 0xF000F000F000F000ULL) >> 12);
+}
+
+/** @brief Mirror a packed board top to bottom.
+ * @param b the packed board
+ * @return uint64_t
+ */
+uint64_t pack_flip(uint64_t b) {
+	return (b << 48) | ((b & 0xFFFF0000ULL) << 16) | ((b >> 16) & 0xFFFF0000ULL) | (b >> 48);
+}
+
+/** @brief Get the smallest of the 8 symmetries of a packed board.
+ * @param b the packed board
+ * @return uint64_t
+ */
+uint64_t pack_canonical(uint64_t b) {
+	uint64_t m = pack_mirror(b);
+	uint64_t turns[4] = {b, m, pack_flip(b), pack_flip(m)};
+	uint64_t smallest = b;
+
+	for (int i = 0; i < 4; ++i) {
+		uint64_t t = pack_transpose(turns[i]);
+		if (turns[i] < smallest) {
+			smallest = turns[i];
+		}
+		if (t < smallest) {
+			smallest = t;
+		}
+	}
+	return smallest;
+}
+
+/** @brief Hash a board read in one of its 8 symmetries.
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @param s the symmetry: bit 0 mirrors left to right, bit 1 top to bottom, bit 2 swaps rows and columns
+ * @return uint64_t
+ */
+static uint64_t hash_symmetry(const unsigned char *a, int y, int s) {
+	uint64_t h = 14695981039346656037ULL;  /* FNV-1a */
+	for (int i = 0; i < y; ++i) {
+		for (int j = 0; j < y; ++j) {
+			int r = i, c = j;
+			if (s & 1) {
+				c = y - 1 - c;
+			}
+			if (s & 2) {
+				r = y - 1 - r;
+			}
+			if (s & 4) {
+				int temp = r;
+				r = c;
+				c = temp;
+			}
+			h = (h ^ a[r * y + c]) * 1099511628211ULL;
+		}
+	}
+	return h;
+}
+
+/** @brief Get the cache key of a board. The keys of 4 x 4 boards with
+ * exponents below 16 are the packed boards, so they never collide;
+ * the other keys are hashes.
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @param canonical give the same key to the 8 symmetries of the board
+ * @return uint64_t
+ */
+uint64_t board_key(const unsigned char *a, int y, bool canonical) {
+	bool packable = y == 4;
+	for (int i = 0; i < y * y && packable == true; ++i) {
+		packable = a[i] < 16;
+	}
+
+	if (packable == true) {
+		uint64_t b = board_pack(a);
+		return canonical == true ? pack_canonical(b) : b;
+	}
+
+	uint64_t smallest = hash_symmetry(a, y, 0);
+	for (int s = 1; s < CANONICAL_SYMMETRIES && canonical == true; ++s) {
+		uint64_t h = hash_symmetry(a, y, s);
+		if (h < smallest) {
+			smallest = h;
+		}
+	}
+	return smallest;
+}
@@ -0,0 +1,11 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CANONICAL_SYMMETRIES 8  /* rotations and reflections of the board */
+
+uint64_t board_pack(const unsigned char *a);
+uint64_t pack_transpose(uint64_t b);
+uint64_t pack_mirror(uint64_t b);
+uint64_t pack_flip(uint64_t b);
+uint64_t pack_canonical(uint64_t b);
+uint64_t board_key(const unsigned char *a, int y, bool canonical);
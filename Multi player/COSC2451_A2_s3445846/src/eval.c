@@ -0,0 +1,212 @@
+/** @file eval.c
+ * @brief This file scores a game board for the AI. Each row and column is
+ * scored on its own (empty slots, possible merges, monotonicity,
+ * smoothness and big numbers in the corners) and the scores of every
+ * possible line are precomputed, so scoring a board only reads a table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "eval.h"
+
+static const char *term_names[EVAL_TERMS] = {
+	"empty", "merge", "monotonicity", "smoothness", "corner"
+};
+
+/** @brief Get the name of a term, as written in the weights file.
+ * @param term index of the term
+ * @return the name
+ */
+const char *eval_term_name(int term) {
+	return term_names[term];
+}
+
+/** @brief Set the weights used when there is no weights file.
+ * @param w the weights
+ * @return none
+ */
+void eval_default_weights(struct weights *w) {
+	w->value[EVAL_EMPTY] = 270.0f;
+	w->value[EVAL_MERGE] = 700.0f;
+	w->value[EVAL_MONOTONICITY] = 47.0f;
+	w->value[EVAL_SMOOTHNESS] = 10.0f;
+	w->value[EVAL_CORNER] = 20.0f;
+}
+
+/** @brief Read the weights from a file of "name = value" lines,
+ * lines starting with '#' are comments and missing terms are not changed.
+ * @param path the weights file
+ * @param w the weights
+ * @return false if the file cannot be opened
+ */
+bool eval_load_weights(const char *path, struct weights *w) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return false;
+	}
+
+	char line[128];
+	while (fgets(line, sizeof(line), f) != NULL) {
+		char name[32];
+		float value;
+		if (line[0] == '#' || sscanf(line, " %31[a-z_] = %f", name, &value) != 2) {
+			continue;
+		}
+		for (int i = 0; i < EVAL_TERMS; ++i) {
+			if (strcmp(name, term_names[i]) == 0) {
+				w->value[i] = value;
+			}
+		}
+	}
+
+	fclose(f);
+	return true;
+}
+
+/** @brief Write the weights in the format read by eval_load_weights().
+ * @param path the weights file
+ * @param w the weights
+ * @return false if the file cannot be written
+ */
+bool eval_save_weights(const char *path, const struct weights *w) {
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		return false;
+	}
+
+	fprintf(f, "# Weights of the evaluation used by the AI (smart_AI).\n");
+	for (int i = 0; i < EVAL_TERMS; ++i) {
+		fprintf(f, "%s = %g\n", term_names[i], w->value[i]);
+	}
+	return fclose(f) == 0;
+}
+
+/** @brief Score one row or column.
+ * @param line the exponents of the line
+ * @param n number of slots of the line
+ * @param w the weights
+ * @return float
+ */
+static float line_score(const unsigned char *line, int n, const struct weights *w) {
+	float empty = 0, merges = 0, left = 0, right = 0, smooth = 0;
+	int previous = 0, counter = 0;
+
+	for (int i = 0; i < n; ++i) {
+		if (line[i] == 0) {
+			empty++;
+			continue;
+		}
+		if (line[i] == previous) {  /* numbers that can be combined, ignoring empty slots */
+			counter++;
+		} else if (counter > 0) {
+			merges += 1 + counter;
+			counter = 0;
+		}
+		previous = line[i];
+	}
+	if (counter > 0) {
+		merges += 1 + counter;
+	}
+
+	for (int i = 1; i < n; ++i) {
+		float a = line[i - 1], b = line[i];
+		float a4 = a * a * a * a, b4 = b * b * b * b;
+		if (a > b) {  /* decreasing towards the end of the line */
+			left += a4 - b4;
+		} else {
+			right += b4 - a4;
+		}
+		if (a != 0 && b != 0) {
+			smooth += a > b ? a - b : b - a;
+		}
+	}
+
+	float corner = line[0] > line[n - 1] ? line[0] : line[n - 1];
+
+	return w->value[EVAL_EMPTY] * empty + w->value[EVAL_MERGE] * merges
+		- w->value[EVAL_MONOTONICITY] * (left < right ? left : right)
+		- w->value[EVAL_SMOOTHNESS] * smooth + w->value[EVAL_CORNER] * corner * corner;
+}
+
+/** @brief Precompute the score of every line of a board size.
+ * @param e the evaluator
+ * @param y colum length of game board
+ * @param w the weights
+ * @return false if there is no memory for the table
+ */
+bool eval_init(struct evaluator *e, int y, const struct weights *w) {
+	e->y = y;
+	e->w = *w;
+	e->rows = NULL;
+	if (y > EVAL_TABLE_LENGTH) {  /* the table would not fit in memory, score lines directly */
+		return true;
+	}
+
+	/* a line is indexed by its exponents, 4 bits each (bigger ones count as 15) */
+	long count = 1L << (4 * y);
+	e->rows = malloc(count * sizeof(float));
+	if (e->rows == NULL) {
+		return false;
+	}
+	for (long key = 0; key < count; ++key) {
+		unsigned char line[EVAL_TABLE_LENGTH];
+		for (int i = 0; i < y; ++i) {
+			line[i] = (key >> (4 * i)) & 15;
+		}
+		e->rows[key] = line_score(line, y, w);
+	}
+	return true;
+}
+
+/** @brief Free the table of an evaluator.
+ * @param e the evaluator
+ * @return none
+ */
+void eval_free(struct evaluator *e) {
+	free(e->rows);
+	e->rows = NULL;
+}
+
+/** @brief Get the index of a line in the table.
+ * @param a the exponents of the game board
+ * @param start position of the first slot of the line
+ * @param step distance between 2 slots of the line
+ * @param n number of slots of the line
+ * @return the index
+ */
+static inline unsigned int line_key(const unsigned char *a, int start, int step, int n) {
+	unsigned int key = 0;
+	for (int i = 0; i < n; ++i) {
+		unsigned int e = a[start + i * step];
+		key |= (e > 15 ? 15 : e) << (4 * i);
+	}
+	return key;
+}
+
+/** @brief Score a game board, the higher the better.
+ * @param e the evaluator of the board size
+ * @param a the exponents of the game board
+ * @return float
+ */
+float eval_board(const struct evaluator *e, const unsigned char *a) {
+	int y = e->y;
+	float score = 0;
+
+	if (e->rows != NULL) {
+		for (int i = 0; i < y; ++i) {
+			score += e->rows[line_key(a, i * y, 1, y)];  /* row */
+			score += e->rows[line_key(a, i, y, y)];  /* column */
+		}
+	} else {
+		unsigned char line[64];
+		for (int i = 0; i < y; ++i) {
+			score += line_score(a + i * y, y, &e->w);
+			for (int j = 0; j < y; ++j) {
+				line[j] = a[j * y + i];
+			}
+			score += line_score(line, y, &e->w);
+		}
+	}
+	return score;
+}
@@ -0,0 +1,29 @@
+#include <stdbool.h>
+
+#define EVAL_FILE "eval.conf"
+#define EVAL_TERMS 5
+#define EVAL_TABLE_LENGTH 5  /* longest line scored with a lookup table */
+
+/* terms of the evaluation, in the order of struct weights */
+enum { EVAL_EMPTY, EVAL_MERGE, EVAL_MONOTONICITY, EVAL_SMOOTHNESS, EVAL_CORNER };
+
+/** @struct Weight of every term of the evaluation.
+ */
+struct weights {
+	float value[EVAL_TERMS];
+};
+
+/** @struct Evaluation of a board size: the score of every possible
+ * row is computed once, so a board is scored with 2 x y table reads.
+ */
+struct evaluator {
+	int y; struct weights w; float *rows;  /* rows is NULL if the lines are too long for a table */
+};
+
+const char *eval_term_name(int term);
+void eval_default_weights(struct weights *w);
+bool eval_load_weights(const char *path, struct weights *w);
+bool eval_save_weights(const char *path, const struct weights *w);
+bool eval_init(struct evaluator *e, int y, const struct weights *w);
+void eval_free(struct evaluator *e);
+float eval_board(const struct evaluator *e, const unsigned char *a);
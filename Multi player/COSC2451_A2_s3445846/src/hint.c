@@ -0,0 +1,178 @@
+/** @file hint.c
+ * @brief This file contains the hints of the human player: while the player
+ * thinks, a thread searches the board 1 move deeper at a time and keeps the
+ * best move of the deepest search finished. A new board stops the search
+ * at once and the same thread starts again on it, nobody waits for it.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "key_algorithm.h"
+#include "eval.h"
+#include "ntuple.h"
+#include "search.h"
+#include "hint.h"
+
+/** @struct The searching thread and the board it searches.
+ */
+struct hint {
+	pthread_t worker; pthread_mutex_t lock; pthread_cond_t work;
+	unsigned char board[MAX_LENGTH * MAX_LENGTH]; int y; long job; bool quit;  /* job: number of the board */
+	atomic_bool stop;  /* the board changed, the running search is useless */
+	int best; int depth;  /* best move of the deepest search finished on the board, -1 if none yet */
+	struct evaluator evaluator; bool use_evaluator; struct ntuple network; bool use_network;
+	struct search search;
+};
+
+/** @brief Search every new board until it is replaced.
+ * @param param the hint
+ * @return none
+ */
+static void *worker(void *param) {
+	struct hint *h = param;
+	long seen = 0;
+
+	pthread_mutex_lock(&h->lock);
+	while (true) {
+		while (h->quit == false && h->job == seen) {
+			pthread_cond_wait(&h->work, &h->lock);
+		}
+		if (h->quit == true) {
+			break;
+		}
+
+		unsigned char board[MAX_LENGTH * MAX_LENGTH];
+		seen = h->job;
+		memcpy(board, h->board, h->y * h->y);
+		atomic_store(&h->stop, false);  /* under the lock: a newer board sets it again */
+		pthread_mutex_unlock(&h->lock);
+
+		for (int depth = 1; depth <= SEARCH_MAX_DEPTH; ++depth) {
+			int dir = search_best(&h->search, board, depth, NULL);
+			if (h->search.timeout == true) {
+				break;
+			}
+
+			pthread_mutex_lock(&h->lock);
+			if (h->job == seen) {
+				h->best = dir;
+				h->depth = depth;
+			}
+			pthread_mutex_unlock(&h->lock);
+			if (dir < 0) {
+				break;
+			}
+		}
+		pthread_mutex_lock(&h->lock);
+	}
+	pthread_mutex_unlock(&h->lock);
+	return NULL;
+}
+
+/** @brief Free a hint whose thread is not running.
+ * @param h the hint
+ * @return none
+ */
+static void release(struct hint *h) {
+	pthread_mutex_destroy(&h->lock);
+	pthread_cond_destroy(&h->work);
+	search_free(&h->search);
+	if (h->use_network == true) {
+		ntuple_close(&h->network);
+	}
+	if (h->use_evaluator == true) {
+		eval_free(&h->evaluator);
+	}
+	free(h);
+}
+
+/** @brief Start the hint thread of a board size, with the evaluation
+ * (or the n-tuple network) the AI uses.
+ * @param y colum length of game board
+ * @param cutoff chance below which the search does not look further
+ * @return the hint, NULL if there is no memory or the thread does not start
+ */
+struct hint *hint_start(int y, float cutoff) {
+	struct hint *h = calloc(1, sizeof(struct hint));
+	if (h == NULL) {
+		return NULL;
+	}
+
+	struct weights weights;
+	eval_default_weights(&weights);
+	eval_load_weights(EVAL_FILE, &weights);
+	h->use_evaluator = eval_init(&h->evaluator, y, &weights);
+
+	const char *networks[2] = {NTUPLE_QUANTIZED_FILE, NTUPLE_FILE};
+	for (int i = 0; i < 2 && h->use_network == false; i++) {
+		h->use_network = ntuple_open(&h->network, networks[i], false);
+		if (h->use_network == true && h->network.y != y) {
+			ntuple_close(&h->network);
+			h->use_network = false;
+		}
+	}
+
+	search_init(&h->search, y, h->use_evaluator ? &h->evaluator : NULL, h->use_network ? &h->network : NULL);
+	h->search.cutoff = cutoff;
+	h->search.stop = &h->stop;
+	h->y = y;
+	h->best = -1;
+	atomic_init(&h->stop, false);
+	pthread_mutex_init(&h->lock, NULL);
+	pthread_cond_init(&h->work, NULL);
+	if (pthread_create(&h->worker, NULL, worker, h) != 0) {
+		release(h);
+		return NULL;
+	}
+	return h;
+}
+
+/** @brief Give the board of the player to the hint thread. The search of
+ * the last board is stopped, nothing happens if the board is the same.
+ * @param h the hint
+ * @param a the exponents of the game board
+ * @return none
+ */
+void hint_position(struct hint *h, const unsigned char *a) {
+	pthread_mutex_lock(&h->lock);
+	if (h->job == 0 || memcmp(h->board, a, h->y * h->y) != 0) {
+		memcpy(h->board, a, h->y * h->y);
+		h->job++;
+		h->best = -1;
+		h->depth = 0;
+		atomic_store(&h->stop, true);
+		pthread_cond_signal(&h->work);
+	}
+	pthread_mutex_unlock(&h->lock);
+}
+
+/** @brief Get the best move found so far on the last board, without waiting.
+ * @param h the hint
+ * @param depth number of moves the best move looked ahead
+ * @return the direction, -1 if no search has finished yet or nothing can move
+ */
+int hint_best(struct hint *h, int *depth) {
+	pthread_mutex_lock(&h->lock);
+	int best = h->best;
+	*depth = h->depth;
+	pthread_mutex_unlock(&h->lock);
+	return best;
+}
+
+/** @brief Stop the hint thread and free the hint.
+ * @param h the hint
+ * @return none
+ */
+void hint_stop(struct hint *h) {
+	pthread_mutex_lock(&h->lock);
+	h->quit = true;
+	atomic_store(&h->stop, true);
+	pthread_cond_signal(&h->work);
+	pthread_mutex_unlock(&h->lock);
+
+	pthread_join(h->worker, NULL);
+	release(h);
+}
@@ -0,0 +1,8 @@
+/* Search running in the background on the board of the human player,
+ * so the best move is known when the player asks for it (see hint.c). */
+struct hint;
+
+struct hint *hint_start(int y, float cutoff);
+void hint_position(struct hint *h, const unsigned char *a);
+int hint_best(struct hint *h, int *depth);
+void hint_stop(struct hint *h);
@@ -0,0 +1,128 @@
+/** @file history.c
+ * @brief This file keeps the positions of the game
+ * so the moves can be undone and redone.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "history.h"
+
+/** @brief Store a position in the ring buffer.
+ * @param h the history
+ * @param i the position counted from the start of the game
+ * @param a the array containing the exponents of the game board
+ * @param score the current score
+ * @param seed the random seed of the game board
+ * @return none
+ */
+static void pack(struct history *h, long i, unsigned char *a, long long score, unsigned int seed) {
+	memcpy(h->cells + (i % HISTORY_SIZE) * h->slots, a, h->slots);
+	h->records[i % HISTORY_SIZE].score = score;
+	h->records[i % HISTORY_SIZE].seed = seed;
+}
+
+/** @brief Restore a position from the ring buffer.
+ * @param h the history
+ * @param i the position counted from the start of the game
+ * @param a the array containing the exponents of the game board
+ * @param score the current score
+ * @param seed the random seed of the game board
+ * @return none
+ */
+static void unpack(struct history *h, long i, unsigned char *a, long long *score, unsigned int *seed) {
+	memcpy(a, h->cells + (i % HISTORY_SIZE) * h->slots, h->slots);
+	*score = h->records[i % HISTORY_SIZE].score;
+	*seed = h->records[i % HISTORY_SIZE].seed;
+}
+
+/** @brief Create the history of a board, its positions take slots bytes each.
+ * @param slots number of slots of the game board
+ * @return the history, NULL if there is no memory
+ */
+struct history *history_start(int slots) {
+	struct history *h = malloc(sizeof(struct history) + (size_t) HISTORY_SIZE * slots);
+	if (h == NULL) {
+		return NULL;
+	}
+	h->first = 0;
+	h->current = 0;
+	h->last = 0;
+	h->slots = slots;
+	return h;
+}
+
+/** @brief Free a history.
+ * @param h the history, can be NULL
+ * @return none
+ */
+void history_stop(struct history *h) {
+	free(h);
+}
+
+/** @brief Forget all the positions and start from the given one.
+ * @param h the history, NULL if there is none (nothing is kept)
+ * @param a the array containing the exponents of the game board
+ * @param score the current score
+ * @param seed the random seed of the game board
+ * @return none
+ */
+void history_clear(struct history *h, unsigned char *a, long long score, unsigned int seed) {
+	if (h == NULL) {
+		return;
+	}
+	h->first = 0;
+	h->current = 0;
+	h->last = 0;
+	pack(h, 0, a, score, seed);
+}
+
+/** @brief Add the position after a move, the positions that were undone are dropped.
+ * @param h the history, NULL if there is none (nothing is kept)
+ * @param a the array containing the exponents of the game board
+ * @param score the current score
+ * @param seed the random seed of the game board
+ * @return none
+ */
+void history_push(struct history *h, unsigned char *a, long long score, unsigned int seed) {
+	if (h == NULL) {
+		return;
+	}
+	h->current++;
+	h->last = h->current;
+	if (h->current - h->first >= HISTORY_SIZE) {  /* overwrite the oldest position */
+		h->first = h->current - HISTORY_SIZE + 1;
+	}
+	pack(h, h->current, a, score, seed);
+}
+
+/** @brief Go back to the previous position.
+ * @param h the history, NULL if there is none (nothing is kept)
+ * @param a the array containing the exponents of the game board
+ * @param score the current score
+ * @param seed the random seed of the game board
+ * @return false if there is no position to go back to
+ */
+bool history_undo(struct history *h, unsigned char *a, long long *score, unsigned int *seed) {
+	if (h == NULL || h->current == h->first) {
+		return false;
+	}
+	h->current--;
+	unpack(h, h->current, a, score, seed);
+	return true;
+}
+
+/** @brief Go forward to the position that was undone.
+ * @param h the history, NULL if there is none (nothing is kept)
+ * @param a the array containing the exponents of the game board
+ * @param score the current score
+ * @param seed the random seed of the game board
+ * @return false if there is no position to go forward to
+ */
+bool history_redo(struct history *h, unsigned char *a, long long *score, unsigned int *seed) {
+	if (h == NULL || h->current == h->last) {
+		return false;
+	}
+	h->current++;
+	unpack(h, h->current, a, score, seed);
+	return true;
+}
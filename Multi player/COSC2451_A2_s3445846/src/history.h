@@ -0,0 +1,25 @@
+#include <stdbool.h>
+
+#define HISTORY_SIZE 16384  /* number of positions kept, enough for a whole AI game */
+
+/** @struct The score and the random seed used for the next spawn of one position.
+ */
+struct record {
+	long long score; unsigned int seed;
+};
+
+/** @struct Ring buffer of positions, the oldest ones are dropped when it is full.
+ * The exponents of position i are the slots bytes at cells + (i % HISTORY_SIZE) * slots.
+ */
+struct history {
+	struct record records[HISTORY_SIZE];
+	long first; long current; long last;  /* positions counted from the start of the game */
+	int slots; unsigned char cells[];
+};
+
+struct history *history_start(int slots);
+void history_stop(struct history *h);
+void history_clear(struct history *h, unsigned char *a, long long score, unsigned int seed);
+void history_push(struct history *h, unsigned char *a, long long score, unsigned int seed);
+bool history_undo(struct history *h, unsigned char *a, long long *score, unsigned int *seed);
+bool history_redo(struct history *h, unsigned char *a, long long *score, unsigned int *seed);
@@ -1,304 +1,211 @@
 /** @file key_algorithm.c
  * @brief This is the file to store the functions
  * to control the game board based on player's input.
+ * Every function is generated once per board size, so the
+ * loops over a row or a column are unrolled by the compiler.
+ * A slot stores the exponent of its number (1 for 2, 2 for 4, ...)
+ * and 0 when it is empty.
  */
 
 #include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "key_algorithm.h"
+#include "rng.h"
 
-/** @brief This function will change and re-arrange 
- * the values of the table when users press 
- * the "DOWN" button on the keyboard.
+/** @brief Slide one row or column of the table towards its first slot
+ * and combine the matching pairs.
  * @param a the array containing the numbers of the game board
- * @param s the current score 
- * @param is boolean to check if the numbers are able to move down
- * @param im boolean to check if there is at least a matching pair of numbers
- * @param y colum length of game board
- * @return none
+ * @param start position of the first slot of the line (the one numbers move to)
+ * @param step distance between 2 slots of the line
+ * @param n number of slots of the line
+ * @param s the current score
+ * @param im boolean set to true if a matching pair is combined
+ * @return true if a number has moved
  */
-void down(int *a, int *s, bool *is, bool *im, int *y) {
-	bool isStuck = true;  /* check if the slot can be moved */
-	bool isMatch = false;  /* check if there are matching slots */
-
-	for (int i = (*y * *y) - 1; i > (*y * *y) - (*y + 1); --i)	{  /* start from the bottom of table */
-		for (int j = 0; j < (*y * *y) - (*y - 1);) {					
-			int temp = a[i - j];
-
-			if (temp != 0) {  /* if the key value is not 0 */
-				bool check = false;
-
-				/* search through other rows of a column */
-				for (int k = j + *y; k < (*y * *y) - (*y - 1); k += *y)	{  
-					if (a[i - k] == temp) {  /* if the 2 values are match */
-						a[i - k] = temp * 2;  /* combine them and double it */
-						*s += temp * 2;  /* add to the total score */
-						a[i - j] = 0;  /* change data of key value to 0 */
-						j = k + *y;  // change key value to the row next to 
-									// the matching value of a column.									
-						check = true;	
-						isMatch = true;																
-						break;																						
-
-						// if there is a different number 
-						// in front of the key value 						 
-					} else if (a[i - k] != temp && a[i - k] != 0) {  
-						break;
-					}
-				}
+static inline __attribute__((always_inline))
+bool slide(unsigned char *a, int start, int step, const int n, long long *s, bool *im) {
+	unsigned char line[MAX_LENGTH];  /* numbers of the line after the move */
+	int count = 0;
+	unsigned char last = 0;  /* last number that can still be combined */
+
+	for (int j = 0; j < n; ++j) {
+		unsigned char temp = a[start + j * step];
+
+		if (temp == 0) {  /* skip empty slots */
+			continue;
+		} else if (temp == last) {  /* if the 2 values are match */
+			line[count - 1] = temp + 1;  /* combine them and double it */
+			*s += 1LL << (temp + 1);  /* add to the total score */
+			*im = true;
+			last = 0;  /* a number is only combined once per move */
+		} else {
+			line[count++] = temp;
+			last = temp;
+		}
+	}
 
-				// if there's no matching value with the key value 
-				// in the same column				 
-				if (check == false) {  
-					j += *y;  /* change key value to the next row of a column */
-				}
-			} else {
-				j += *y;  /* change key value to the next row of a column */
-			}					
-		}					
-	}		
+	bool moved = false;
+	for (int j = 0; j < n; ++j) {
+		unsigned char value = j < count ? line[j] : 0;
+		if (a[start + j * step] != value) {
+			a[start + j * step] = value;
+			moved = true;
+		}
+	}
+	return moved;
+}
 
+/** @brief Check if the game board is full and there is no matching pairs left.
+ * @param a the array containing the numbers of the game board
+ * @param n column length of game board
+ * @return true if the game is over
+ */
+static inline __attribute__((always_inline))
+bool is_failing(unsigned char *a, const int n) {
+	for (int i = 0; i < n * n; ++i) {  /* check if the game board is full */
+		if (a[i] == 0) {
+			return false;
+		}
+	}
 
-	/* move all values down (to the bottom of the table) */
-	/* start from the botton of the table */
-	for (int i = (*y * *y) - 1; i > (*y * *y) - (*y + 1); --i)	{  
-		for (int j = 0; j < (*y * *y) - (*y - 1); j += *y) {					
-			if (a[i - j] == 0) {  /* key value is 0 */
-				for (int k = j + *y; k < (*y * *y) - (*y - 1); k += *y) {
-					if (a[i - k] != 0) {  // the value is not 0 in the same 
-										  // column with the key value 										   
-						a[i - j] = a[i - k];  /* change key value to the targeted value */
-						a[i - k] = 0;  /* set targeted value to 0 */	
-						isStuck = false;															   					
-						break;  /* move to next row of the column */
-					}
-				}
+	/* the board is full, so only neighbours can match */
+	for (int i = 0; i < n; ++i) {
+		for (int j = 0; j < n - 1; ++j) {
+			if (a[i * n + j] == a[i * n + j + 1] || a[j * n + i] == a[(j + 1) * n + i]) {
+				return false;
 			}
 		}
 	}
+	return true;
+}
 
-	*is = isStuck;		
-	*im = isMatch;
+/* The moves of a board of n x n slots, n is a constant so the loops are unrolled */
+#define DEFINE_MOVES(name, n) \
+	static void down_##name(unsigned char *a, long long *s, bool *is, bool *im, int *y) { \
+		bool moved = false; \
+		*im = false; \
+		for (int i = 0; i < (n); ++i) { \
+			moved |= slide(a, (n) * ((n) - 1) + i, -(n), (n), s, im); \
+		} \
+		*is = !moved; \
+	} \
+	static void up_##name(unsigned char *a, long long *s, bool *is, bool *im, int *y) { \
+		bool moved = false; \
+		*im = false; \
+		for (int i = 0; i < (n); ++i) { \
+			moved |= slide(a, i, (n), (n), s, im); \
+		} \
+		*is = !moved; \
+	} \
+	static void right_##name(unsigned char *a, long long *s, bool *is, bool *im, int *y) { \
+		bool moved = false; \
+		*im = false; \
+		for (int i = 0; i < (n); ++i) { \
+			moved |= slide(a, i * (n) + (n) - 1, -1, (n), s, im); \
+		} \
+		*is = !moved; \
+	} \
+	static void left_##name(unsigned char *a, long long *s, bool *is, bool *im, int *y) { \
+		bool moved = false; \
+		*im = false; \
+		for (int i = 0; i < (n); ++i) { \
+			moved |= slide(a, i * (n), 1, (n), s, im); \
+		} \
+		*is = !moved; \
+	} \
+	static void check_failing_##name(unsigned char *a, bool *fail, int *y) { \
+		*fail = is_failing(a, (n)); \
+	} \
+	static const struct moves moves_##name = { \
+		down_##name, up_##name, right_##name, left_##name, check_failing_##name \
+	};
+
+DEFINE_MOVES(3, 3)
+DEFINE_MOVES(4, 4)
+DEFINE_MOVES(5, 5)
+DEFINE_MOVES(6, 6)
+DEFINE_MOVES(7, 7)
+DEFINE_MOVES(8, 8)
+
+/** @brief Choose the moves generated for the size of the game board,
+ * this is done once when the size is known.
+ * @param y colum length of game board
+ * @return the moves of that board size, NULL if it is not 3 to MAX_LENGTH
+ */
+const struct moves *get_moves(int y) {
+	switch (y) {
+		case 3:
+			return &moves_3;
+		case 4:
+			return &moves_4;
+		case 5:
+			return &moves_5;
+		case 6:
+			return &moves_6;
+		case 7:
+			return &moves_7;
+		case 8:
+			return &moves_8;
+		default:
+			return NULL;  /* a line of the board would not fit in slide() */
+	}
+}
+
+/** @brief This function will change and re-arrange
+ * the values of the table when users press
+ * the "DOWN" button on the keyboard.
+ * @param a the array containing the numbers of the game board
+ * @param s the current score
+ * @param is boolean to check if the numbers are able to move down
+ * @param im boolean to check if there is at least a matching pair of numbers
+ * @param y colum length of game board
+ * @return none
+ */
+void down(unsigned char *a, long long *s, bool *is, bool *im, int *y) {
+	get_moves(*y)->down(a, s, is, im, y);
 }
 
-/** @brief This function will change and re-arrange 
- * the values of the table when users press 
+/** @brief This function will change and re-arrange
+ * the values of the table when users press
  * the "UP" button on the keyboard.
  * @param a the array containing the numbers of the game board
- * @param s the current score 
+ * @param s the current score
  * @param is boolean to check if the numbers are able to move up
  * @param im boolean to check if there is at least a matching pair of numbers
  * @param y colum length of game board
  * @return none
  */
-void up(int *a, int *s, bool *is, bool *im, int *y) {
-	bool isStuck = true;  /* check if the slot can be moved */
-	bool isMatch = false;  /* check if there are matching slots */
-
-	for (int i = 0; i < *y; ++i)	{  /* start from the top of table */
-		for (int j = 0; j < (*y * *y) - (*y - 1);)	{					
-			int temp = a[i + j];
-
-			if (temp != 0) {  /* if the key value is not 0 */
-				bool check = false;
-
-				/* search through other rows of a column */
-				for (int k = j + *y; k < (*y * *y) - (*y - 1); k += *y)	{  
-					if (a[i + k] == temp) {  /* if the 2 values are match */
-						a[i + k] = temp * 2;  /* combine them and double it */
-						*s += temp * 2;  /* add to the total score */
-						a[i + j] = 0;  /* change data of key value to 0 */
-						j = k + *y;	// change key value to the row next to 
-									// the matching value of a column 									 
-						check = true;			
-						isMatch = true;													
-						break;
-
-						// if there is a different number 
-						// in front of the key value 						
-					} else if (a[i + k] != temp && a[i + k] != 0) {
-						break;
-					}
-				}
-
-				// if there's no matching value with the key value 
-				// in the same column				 
-				if (check == false) {
-					j += *y;  /* change key value to the next row of a column */
-				}
-			} else {
-				j += *y;  /* change key value to the next row of a column */
-			}					
-		}					
-	}					
-
-
-	// move all values up
-	// (to the top of the table)	  
-	for (int i = 0; i < *y; ++i) {  /* start from the top of table */
-		for (int j = 0; j < (*y * *y) - (*y - 1); j += *y)	{					
-			if (a[i + j] == 0) {  /* key value is 0 */
-				for (int k = j + *y; k < (*y * *y) - (*y - 1); k += *y) {
-					if (a[i + k] != 0) {  /** the value is not 0 in the same 
-										   * column with the key value 
-										   */
-						a[i + j] = a[i + k];  /* change key value to the targeted value */
-						a[i + k] = 0;  /* set targeted value to 0 */	
-						isStuck = false;					
-						break;  /* move to next row of the column */
-					} 
-				}
-			}
-		}
-	}
-
-	*is = isStuck;		
-	*im = isMatch;
+void up(unsigned char *a, long long *s, bool *is, bool *im, int *y) {
+	get_moves(*y)->up(a, s, is, im, y);
 }
 
-/** @brief This function will change and re-arrange 
- * the values of the table when users press 
+/** @brief This function will change and re-arrange
+ * the values of the table when users press
  * the "RIGHT" button on the keyboard.
  * @param a the array containing the numbers of the game board
- * @param s the current score 
+ * @param s the current score
  * @param is boolean to check if the numbers are able to move right
  * @param im boolean to check if there is at least a matching pair of numbers
  * @param y colum length of game board
  * @return none
  */
-void right(int *a, int *s, bool *is, bool *im, int *y) {
-	bool isStuck = true;  /* check if the slot can be moved */
-	bool isMatch = false;  /* check if there are matching slots */
-
-	for (int i = *y - 1; i < (*y * *y); i += *y)	{  /* start from the right of table */
-		for (int j = 0; j < *y;) {					
-			int temp = a[i - j];
-
-			if (temp != 0) {  /* if the key value is not 0 */
-				bool check = false;
-
-				for (int k = j + 1; k < *y; ++k)	{  /* search through other columns of a row */
-					if (a[i - k] == temp) {  /* if the 2 values are match */
-						a[i - k] = temp * 2;  /* combine them and double it */
-						*s += temp * 2;  /* add to the total score */
-						a[i - j] = 0;  /* change data of key value to 0 */
-						j = k + 1;  // change key value to the row next to 
-									// the matching value of a column 									
-						check = true;	
-						isMatch = true;
-						break;																						
-
-						// if there is a different number 
-						// in front of the key value 						 
-					} else if (a[i - k] != temp && a[i - k] != 0) {  
-						break;
-					}
-				}
-
-				// if there's no matching value with the key value 
-				// in the same column				
-				if (check == false) {  
-					j++;  /* change key value to the next column of a row */
-				}
-			} else {
-				j++;  /* change key value to the next column of a row */
-			}					
-		}					
-	}		
-
-
-	// move all values to 
-	// the right of the table	  
-	for (int i = *y - 1; i < (*y * *y); i += *y) {  /* start from the right of the table */
-		for (int j = 0; j < *y; j++) {
-			if (a[i - j] == 0) {  /* key value is 0 */
-				for (int k = j + 1; k < *y; k++) {
-					if (a[i - k] != 0) {  // the value is not 0 in the same 
-										  // row with the key value 										    
-						a[i - j] = a[i - k];  /* change key value to the targeted value */
-						a[i - k] = 0;  /* set targeted value to 0 */
-					    isStuck = false;
-						break;  /* move to next column of the row */
-					}
-				}
-			}
-		}
-	}
-
-	*is = isStuck;		
-	*im = isMatch;
+void right(unsigned char *a, long long *s, bool *is, bool *im, int *y) {
+	get_moves(*y)->right(a, s, is, im, y);
 }
 
-/** @brief This function will change and re-arrange 
- * the values of the table when users press 
+/** @brief This function will change and re-arrange
+ * the values of the table when users press
  * the "LEFT" button on the keyboard.
  * @param a the array containing the numbers of the game board
- * @param s the current score 
+ * @param s the current score
  * @param is boolean to check if the numbers are able to move left
  * @param im boolean to check if there is at least a matching pair of numbers
  * @param y colum length of game board
  * @return none
  */
-void left(int *a, int *s, bool *is, bool *im, int *y) {
-	bool isStuck = true;  /* check if the slot can be moved */
-	bool isMatch = false;  /* check if there are matching slots */
-
-	for (int i = 0; i < (*y * *y) - (*y - 1); i += *y)	{  /* start from the right of table */
-		for (int j = 0; j < *y;)	{					
-			int temp = a[i + j];
-
-			if (temp != 0) {  /* if the key value is not 0 */
-				bool check = false;
-
-				for (int k = j + 1; k < *y; ++k)	{  /* search through other rows of a column */
-					if (a[i + k] == temp) {  /* if the 2 values are match */
-						a[i + k] = temp * 2;  /* combine them and double it */
-						*s += temp * 2;  /* add to the total score */
-						a[i + j] = 0;  /* change data of key value to 0 */
-						j = k + 1;	// change key value to the row next to 
-									// the matching value of a column 									 
-						check = true;	
-						isMatch = true;															
-						break;
-
-						// if there is a different number 
-						// in front of the key value 						 
-					} else if (a[i + k] != temp && a[i + k] != 0) {
-						break;
-					}
-				}
-
-				// if there's no matching value with the key value 
-				// in the same column				 
-				if (check == false) {
-					j++;  /* change key value to the next row of a column */
-				}
-			} else {
-				j++;  /* change key value to the next row of a column */
-			}					
-		}					
-	}					
-
-
-	// move all values up
-	// (to the top of the table)	  
-	/* start from the right of table */
-	for (int i = 0; i < (*y * *y) - (*y - 1); i += *y)	{  
-		for (int j = 0; j < *y; j++) {					
-			if (a[i + j] == 0) {  /* key value is 0 */
-				for (int k = j + 1; k < *y; k++) {
-					if (a[i + k] != 0) {  // the value is not 0 in the same 
-										  // column with the key value 										    
-						a[i + j] = a[i + k];  /* change key value to the targeted value */
-						a[i + k] = 0;  /* set targeted value to 0 */
-						isStuck = false;
-						break;  /* move to next row of the column */
-					} 
-				}
-			}
-		}
-	}
-
-	*is = isStuck;		
-	*im = isMatch;
+void left(unsigned char *a, long long *s, bool *is, bool *im, int *y) {
+	get_moves(*y)->left(a, s, is, im, y);
 }
 
 /** @brief This function checks if the game board is full
@@ -308,143 +215,110 @@ void left(int *a, int *s, bool *is, bool *im, int *y) {
  * @param y colum length of game board
  * @return none
  */
-void check_failing(int *a, bool *fail, int *y) {  
-	bool isFull = true;
-	bool isFail = true;
+void check_failing(unsigned char *a, bool *fail, int *y) {
+	get_moves(*y)->check_failing(a, fail, y);
+}
 
-	/* check if the game board is full */
-	for (int i = 0; i < (*y * *y); ++i) {
-		if (*(a + i) == 0) {
-			isFull = false;
+/** @brief Move the game board in a direction.
+ * @param m the moves of the board size
+ * @param dir MOVE_DOWN, MOVE_UP, MOVE_LEFT or MOVE_RIGHT
+ * @param a the array containing the numbers of the game board
+ * @param s the current score
+ * @param y colum length of game board
+ * @return true if a number has moved
+ */
+bool move_table(const struct moves *m, int dir, unsigned char *a, long long *s, int *y) {
+	bool isStuck, isMatch;
+	switch (dir) {
+		case MOVE_DOWN:
+			m->down(a, s, &isStuck, &isMatch, y);
+			break;
+		case MOVE_UP:
+			m->up(a, s, &isStuck, &isMatch, y);
+			break;
+		case MOVE_LEFT:
+			m->left(a, s, &isStuck, &isMatch, y);
+			break;
+		default:
+			m->right(a, s, &isStuck, &isMatch, y);
 			break;
-		}
 	}
+	return !isStuck;
+}
 
-	/* check if there's matching values */
-	if (isFull == true) {
-		for (int i = (*y * *y) - 1; i > (*y * *y) - (*y + 1); --i)	{  /* start from the bottom of table */
-			for (int j = 0; j < (*y * *y) - (*y - 1);) {					
-				int temp = a[i - j];
-
-				if (temp != 0) {  /* if the key value is not 0 */
-					bool check = false;
-
-					for (int k = j + *y; k < (*y * *y) - (*y - 1); k += *y)	{  /* search through other rows of a column */
-						if (a[i - k] == temp) {  /* if the 2 values are match */
-							isFail = false;														
-							break;																						
-
-							// if there is a different number 
-							// in front of the key value 							 
-						} else if (a[i - k] != temp && a[i - k] != 0) {  
-							break;
-						}
-					}
-
-					// if there's no matching value with the key value 
-					// in the same column					 
-					if (check == false) {  
-						j += *y;  /* change key value to the next row of a column */
-					}
-				} else {
-					j += *y;  /* change key value to the next row of a column */
-				}					
-			}					
-		}	
-
-		for (int i = 0; i < *y; ++i)	{  /* start from the top of table */
-			for (int j = 0; j < (*y * *y) - (*y - 1);)	{					
-				int temp = a[i + j];
-
-				if (temp != 0) {  /* if the key value is not 0 */
-					bool check = false;
-
-					/* search through other rows of a column */
-					for (int k = j + *y; k < (*y * *y) - (*y - 1); k += *y)	{  
-						if (a[i + k] == temp) {  /* if the 2 values are match */
-							isFail = false;												
-							break;
-
-							// if there is a different number 
-							// in front of the key value 							
-						} else if (a[i + k] != temp && a[i + k] != 0) {
-							break;
-						}
-					}
-
-					// if there's no matching value with the key value 
-					// in the same column					
-					if (check == false) {
-						j += *y;  /* change key value to the next row of a column */
-					}
-				} else {
-					j += *y;  /* change key value to the next row of a column */
-				}					
-			}					
-		}
-
-		for (int i = *y - 1; i < (*y * *y); i += *y)	{  /* start from the left of table */
-			for (int j = 0; j < *y;)	{					
-				int temp = a[i - j];
-
-				if (temp != 0) {  /* if the key value is not 0 */
-					bool check = false;
-
-					for (int k = j + 1; k < *y; ++k)	{  /* search through other columns of a row */
-						if (a[i - k] == temp) {  /* if the 2 values are match */
-							isFail = false;
-							break;																						
+/** @brief Add a new random number to the board (2 or 4).
+ * @param a the array containing the numbers of the game board
+ * @param f game status (game over or not)
+ * @param y colum length of game board
+ * @param seed random seed of the game board
+ * @return none
+ */
+void add_value(unsigned char *a, bool *f, int *y, unsigned int *seed) {
+	int slots = *y * *y;
+
+	unsigned char init_values[] = {1, 2};  /* exponents of 2 and 4 */
+	/* array to store location of empty slot of the table */	 
+	int avail_space[slots];  
+
+	/* check if the table has at least 1 empty slot */	 
+	bool check_value = false;  
+	int count = 0;
+	for (int i = 0; i < slots; ++i) {
+		if (*(a + i) == 0) {			
+			avail_space[count] = i;	 /* store the location */		
+			count++;
+			check_value = true;			
+		} 
+	}	
+
+	if (check_value == true) {  /* the table has at least 1 empty slot */
+		/* generate a random empty slot, the seed is kept in the session */
+		int random_space = rand_r(seed) % count;  
+
+		/* generate a random number (2 or 4) */
+		int random_value = rand_r(seed) % 2;
+
+		/* add random value to that random slot */
+		a[avail_space[random_space]] = init_values[random_value];	
+	} else {
+		*f = true;  /* change game status to "game over" */
+	}	
+}
 
-							// if there is a different number 
-							// in front of the key value 							
-						} else if (a[i - k] != temp && a[i - k] != 0) {  
-							break;
-						}
-					}
+/** @brief Add the n-th new number of a game (2 or 4, half of the time
+ * each, as add_value()), drawn from the counter-based random numbers:
+ * it only depends on the game and n, not on the numbers added before.
+ * @param a the array containing the numbers of the game board
+ * @param f game status (game over or not)
+ * @param y colum length of game board
+ * @param s the random numbers of the game
+ * @param n index of the new number in the game (the 2 first ones are 0 and 1)
+ * @return none
+ */
+void add_value_at(unsigned char *a, bool *f, int *y, const struct rng_stream *s, long n) {
+	int slots = *y * *y, count = 0;
+	int avail_space[slots];
 
-					// if there's no matching value with the key value 
-					// in the same column					
-					if (check == false) {  
-						j++;  /* change key value to the next column of a row */
-					}
-				} else {
-					j++;  /* change key value to the next column of a row */
-				}					
-			}					
+	for (int i = 0; i < slots; ++i) {
+		if (a[i] == 0) {
+			avail_space[count++] = i;
 		}
-
-		for (int i = 0; i < (*y * *y) - (*y - 1); i += *y)	{  /* start from the right of table */
-			for (int j = 0; j < *y;)	{					
-				int temp = a[i + j];
-
-				if (temp != 0) {  /* if the key value is not 0 */
-					bool check = false;
-
-					for (int k = j + 1; k < *y; ++k)	{  /* search through other rows of a column */
-						if (a[i + k] == temp) {  /* if the 2 values are match */
-							isFail = false;														
-							break;
-
-							// if there is a different number 
-							// in front of the key value 							
-						} else if (a[i + k] != temp && a[i + k] != 0) {
-							break;
-						}
-					}
-
-					// if there's no matching value with the key value 
-					// in the same column					
-					if (check == false) {
-						j++;  /* change key value to the next row of a column */
-					}
-				} else {
-					j++;  /* change key value to the next row of a column */
-				}					
-			}					
-		}		
-	} else {
-		isFail = false;
 	}
+	if (count == 0) {
+		*f = true;
+		return;
+	}
+
+	uint32_t r[4];
+	rng_draw(s, n, RNG_SPAWN, r);
+	a[avail_space[rng_below(r[0], count)]] = 1 + (r[1] & 1);
+}
 
-	*fail = isFail;
-}
\ No newline at end of file
+/** @brief Get the score needed to win: 1024 on 3 x 3,
+ * doubled for every extra column.
+ * @param y colum length of game board
+ * @return int
+ */
+int winning_score(int y) {
+	return 1 << (y + 7);
+}
@@ -1,5 +1,26 @@
-void down(int *a, int *s, bool *is, bool *im, int *y);
-void up(int *a, int *s, bool *is, bool *im, int *y);
-void right(int *a, int *s, bool *is, bool *im, int *y);
-void left(int *a, int *s, bool *is, bool *im, int *y);
-void check_failing(int *a, bool *fail, int *y);
+#define MAX_LENGTH 8  /* longest row or column of the game board */
+
+/* directions, in the order the AI tries them */
+enum { MOVE_DOWN, MOVE_UP, MOVE_LEFT, MOVE_RIGHT };
+
+/** @struct Moves of the game board, generated for one board size.
+ */
+struct moves {
+	void (*down)(unsigned char *a, long long *s, bool *is, bool *im, int *y);
+	void (*up)(unsigned char *a, long long *s, bool *is, bool *im, int *y);
+	void (*right)(unsigned char *a, long long *s, bool *is, bool *im, int *y);
+	void (*left)(unsigned char *a, long long *s, bool *is, bool *im, int *y);
+	void (*check_failing)(unsigned char *a, bool *fail, int *y);
+};
+
+const struct moves *get_moves(int y);
+void down(unsigned char *a, long long *s, bool *is, bool *im, int *y);
+void up(unsigned char *a, long long *s, bool *is, bool *im, int *y);
+void right(unsigned char *a, long long *s, bool *is, bool *im, int *y);
+void left(unsigned char *a, long long *s, bool *is, bool *im, int *y);
+void check_failing(unsigned char *a, bool *fail, int *y);
+bool move_table(const struct moves *m, int dir, unsigned char *a, long long *s, int *y);
+void add_value(unsigned char *a, bool *f, int *y, unsigned int *seed);
+struct rng_stream;
+void add_value_at(unsigned char *a, bool *f, int *y, const struct rng_stream *s, long n);
+int winning_score(int y);
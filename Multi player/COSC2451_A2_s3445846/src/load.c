@@ -0,0 +1,523 @@
+/** @file load.c
+ * @brief This program measures the game server (server.c): it opens many
+ * games on a few connections and plays them at a target rate of requests,
+ * then prints the throughput and the latency of the requests per board
+ * size. Each size is measured alone, on its own connections, one after the
+ * other, so the requests of a size never wait behind the ones of another
+ * size. A game opens, reads its board, then moves, adds the new number
+ * after a move and checks if the game is over, and a game over is closed
+ * and another one opened. The moves are random (drawn from the random
+ * numbers of the game, as the Beginner level) or the ones of medium_AI,
+ * played on a copy of the board kept from the answers.
+ *
+ * Usage: ./load [-p socket] [-c connections] [-n sessions] [-r rate]
+ *               [-d seconds] [-y sizes] [-m random|corner] [-s seed]
+ * (default: -p 2048.sock -c 16 -n 3000 -r 0 -d 5 -y 3,4,5 -m random -s 1,
+ * -r is in requests per second for all the games, 0 sends a request as
+ * soon as the answer of the last one of its game is read; with a rate the
+ * latency of a request counts from the time the rate schedules it, so a
+ * server that stalls the games is not measured only by the requests it
+ * lets them send,
+ * -y lists the board sizes, each one is played by all the games for -d seconds)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "key_algorithm.h"
+#include "rng.h"
+#include "ai.h"
+#include "server.h"
+
+#define LOAD_BUFFER 65536  /* bytes of the buffers of a connection */
+#define LOAD_SUB_BITS 5  /* the latency buckets grow by 1/32 */
+#define LOAD_BUCKETS (64 << LOAD_SUB_BITS)
+#define LOAD_MAX_SIZES 6
+#define LOAD_DRAIN 2.0  /* seconds waiting for the last answers */
+
+/* the next request of a game */
+enum { STEP_OPEN, STEP_BOARD, STEP_MOVE, STEP_ADD, STEP_CHECK, STEP_CLOSE };
+
+/** @struct Latencies in nanoseconds counted in buckets, each power of 2
+ * is cut in 32, so a percentile is known within 1/32.
+ */
+struct latency {
+	long long counts[LOAD_BUCKETS]; long long count; long long max;
+};
+
+/** @struct Game played by the load, with its copy of the board.
+ */
+struct game {
+	int connection; int size; int y; uint32_t id; int step; bool waiting;
+	unsigned int seed; long number; long moves; int turn; int dir;  /* number: game of the seed, dir: last move */
+	long long score; double sent;
+	unsigned char board[MAX_LENGTH * MAX_LENGTH];
+};
+
+/** @struct Connection to the server and its games, the tag of a request is the index of the game.
+ */
+struct link {
+	int fd; int *games; int count;
+	size_t in; size_t out;
+	unsigned char input[LOAD_BUFFER]; unsigned char output[LOAD_BUFFER];
+};
+
+/** @struct Results of one board size.
+ */
+struct result {
+	int y; long sessions; long games; long requests; long moves; long errors; double elapsed; long sent;
+	struct latency latency;
+};
+
+/** @struct State of the load.
+ */
+struct load {
+	struct game *games; long count; struct link *links; int connections;
+	struct result results[LOAD_MAX_SIZES]; int sizes;
+	int *ready; long head; long tail;  /* games of the size measured with a request to send, in a ring */
+	bool corner; long sent; long answered; double rate; double seconds; unsigned int seed;
+	double start;  /* start of the measure, request k of a rate is due at start + k / rate */
+};
+
+/** @brief Get the current time in seconds.
+ * @return double
+ */
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/** @brief Get the bucket of a latency.
+ * @param ns the latency in nanoseconds
+ * @return the bucket
+ */
+static int bucket(long long ns) {
+	if (ns < (1 << LOAD_SUB_BITS)) {
+		return ns < 0 ? 0 : ns;
+	}
+	int e = 63 - __builtin_clzll(ns);
+	return ((e - LOAD_SUB_BITS + 1) << LOAD_SUB_BITS) + ((ns >> (e - LOAD_SUB_BITS)) & ((1 << LOAD_SUB_BITS) - 1));
+}
+
+/** @brief Get the smallest latency of a bucket.
+ * @param b the bucket
+ * @return the latency in nanoseconds
+ */
+static long long bucket_start(int b) {
+	if (b < (1 << LOAD_SUB_BITS)) {
+		return b;
+	}
+	int e = (b >> LOAD_SUB_BITS) + LOAD_SUB_BITS - 1;
+	return (1LL << e) + ((long long) (b & ((1 << LOAD_SUB_BITS) - 1)) << (e - LOAD_SUB_BITS));
+}
+
+/** @brief Get a percentile of the latencies.
+ * @param l the latencies
+ * @param p the percentile (0 to 100)
+ * @return the latency in microseconds, the middle of its bucket (at most the max)
+ */
+static double percentile(const struct latency *l, double p) {
+	long long rank = (long long) (p / 100 * l->count), seen = 0;
+	for (int b = 0; b < LOAD_BUCKETS; ++b) {
+		seen += l->counts[b];
+		if (seen > rank) {
+			double middle = (bucket_start(b) + bucket_start(b + 1)) / 2e3;
+			return middle < l->max / 1e3 ? middle : l->max / 1e3;
+		}
+	}
+	return l->max / 1e3;
+}
+
+/** @brief Add a request to the output of its connection.
+ * @param ld the load
+ * @param index the game
+ * @return none
+ */
+static void send_step(struct load *ld, int index) {
+	struct game *g = &ld->games[index];
+	struct link *k = &ld->links[g->connection];
+	struct server_request q;
+	memset(&q, 0, sizeof(q));
+	q.session = g->id;
+	q.tag = index / ld->connections;
+
+	if (g->step == STEP_OPEN) {
+		q.op = SERVER_OPEN;
+		q.arg = g->y;
+		q.value = g->seed;
+		q.session = g->number;
+	} else if (g->step == STEP_BOARD) {
+		q.op = SERVER_BOARD;
+	} else if (g->step == STEP_MOVE) {
+		uint32_t r[4];
+		q.op = SERVER_MOVE;
+		if (ld->corner == true) {
+			g->dir = ai_corner(&g->turn, g->board, g->y);
+		} else {
+			struct rng_stream stream = rng_stream(g->seed, 0, g->number);
+			rng_draw(&stream, g->moves, RNG_AI, r);
+			g->dir = rng_below(r[0], 4);
+		}
+		q.arg = g->dir < 0 ? MOVE_DOWN : g->dir;
+	} else if (g->step == STEP_ADD) {
+		q.op = SERVER_ADD;
+	} else if (g->step == STEP_CHECK) {
+		q.op = SERVER_CHECK;
+	} else {
+		q.op = SERVER_CLOSE;
+	}
+	memcpy(k->output + k->out, &q, sizeof(q));
+	k->out += sizeof(q);
+	g->waiting = true;
+	g->sent = ld->rate > 0 ? ld->start + ld->sent / ld->rate : now();  /* a late request waited for the server */
+	ld->sent++;
+}
+
+/** @brief Read an answer: count its latency, update the copy of the board
+ * and choose the next request of the game.
+ * @param ld the load
+ * @param index the game
+ * @param r the answer
+ * @param payload the bytes after the answer
+ * @return none
+ */
+static void receive(struct load *ld, int index, const struct server_reply *r, const unsigned char *payload) {
+	struct game *g = &ld->games[index];
+	struct result *res = &ld->results[g->size];
+	long long ns = (now() - g->sent) * 1e9;
+	res->latency.counts[bucket(ns)]++;
+	res->latency.count++;
+	res->latency.max = ns > res->latency.max ? ns : res->latency.max;
+	res->requests++;
+	g->waiting = false;
+	ld->answered++;
+
+	if (r->status != SERVER_OK) {
+		res->errors++;
+		g->step = STEP_OPEN;  /* start a new game */
+		g->number += ld->count;
+	} else if (g->step == STEP_OPEN) {
+		g->id = r->value;
+		g->step = STEP_BOARD;
+	} else if (g->step == STEP_BOARD) {
+		memcpy(g->board, payload, g->y * g->y);
+		memcpy(&g->score, payload + g->y * g->y, sizeof(int64_t));
+		g->moves = 0;
+		g->turn = 0;
+		g->step = STEP_MOVE;
+	} else if (g->step == STEP_MOVE) {
+		g->moves++;
+		if (r->a == 1) {
+			move_table(get_moves(g->y), g->dir, g->board, &g->score, &g->y);
+			res->moves++;
+			g->step = STEP_ADD;
+		} else {
+			g->step = g->dir < 0 ? STEP_CLOSE : STEP_MOVE;  /* medium_AI has no move left */
+		}
+	} else if (g->step == STEP_ADD) {
+		g->board[r->a] = r->b;
+		g->step = STEP_CHECK;
+	} else if (g->step == STEP_CHECK) {
+		g->step = r->a == 1 ? STEP_CLOSE : STEP_MOVE;
+	} else {
+		res->games++;
+		g->number += ld->count;  /* the next game of the seed for this game */
+		g->step = STEP_OPEN;
+	}
+	ld->ready[ld->tail++ % ld->count] = index;
+}
+
+/** @brief Write the requests waiting on a connection.
+ * @param k the connection
+ * @return false if the server is gone
+ */
+static bool flush(struct link *k) {
+	size_t done = 0;
+	while (done < k->out) {
+		ssize_t n = write(k->fd, k->output + done, k->out - done);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		done += n;
+	}
+	memmove(k->output, k->output + done, k->out - done);
+	k->out -= done;
+	return true;
+}
+
+/** @brief Read the answers of a connection.
+ * @param ld the load
+ * @param k the connection
+ * @return false if the server is gone
+ */
+static bool drain(struct load *ld, struct link *k) {
+	ssize_t n = read(k->fd, k->input + k->in, LOAD_BUFFER - k->in);
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+		return true;
+	}
+	if (n <= 0) {
+		return false;
+	}
+	k->in += n;
+
+	size_t done = 0;
+	while (k->in - done >= sizeof(struct server_reply)) {
+		struct server_reply r;
+		memcpy(&r, k->input + done, sizeof(r));
+		size_t payload = r.op == SERVER_BOARD && r.status == SERVER_OK ? r.value : 0;
+		if (payload > SERVER_PAYLOAD) {
+			return false;
+		}
+		if (k->in - done < sizeof(r) + payload) {
+			break;
+		}
+		if (r.tag >= k->count) {
+			return false;
+		}
+		receive(ld, k->games[r.tag], &r, k->input + done + sizeof(r));
+		done += sizeof(r) + payload;
+	}
+	memmove(k->input, k->input + done, k->in - done);
+	k->in -= done;
+	return true;
+}
+
+/** @brief Measure one board size: connect, play every game on that size
+ * for the time of the load, wait for the last answers, then disconnect
+ * (the server closes the games of a connection that is gone).
+ * @param ld the load
+ * @param size index of the size in the results
+ * @param address the socket of the server
+ * @return false if the server cannot be reached or is gone
+ */
+static bool phase(struct load *ld, int size, const struct sockaddr_un *address) {
+	struct result *res = &ld->results[size];
+	int epoll = epoll_create1(0);
+	for (int c = 0; c < ld->connections; ++c) {
+		struct link *k = &ld->links[c];
+		k->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+		if (k->fd < 0 || connect(k->fd, (const struct sockaddr *) address, sizeof(*address)) < 0) {
+			perror(address->sun_path);
+			return false;
+		}
+		k->count = 0;
+		k->in = 0;
+		k->out = 0;
+		struct epoll_event e;
+		e.events = EPOLLIN;
+		e.data.u32 = c;
+		epoll_ctl(epoll, EPOLL_CTL_ADD, k->fd, &e);
+	}
+	ld->head = 0;
+	ld->tail = 0;
+	ld->sent = 0;
+	ld->answered = 0;
+	for (long i = 0; i < ld->count; ++i) {
+		struct game *g = &ld->games[i];
+		struct link *k = &ld->links[i % ld->connections];
+		memset(g, 0, sizeof(*g));
+		g->connection = i % ld->connections;
+		g->size = size;
+		g->y = res->y;
+		g->seed = ld->seed;
+		g->number = i;
+		g->step = STEP_OPEN;
+		k->games[k->count++] = i;
+		ld->ready[ld->tail++] = i;
+	}
+	res->sessions = ld->count;
+
+	/* send the requests allowed by the rate, then read the answers */
+	double start = now(), end = start + ld->seconds, stopped = 0;
+	ld->start = start;
+	struct epoll_event events[64];
+	bool ok = true;
+	while (ok == true) {
+		double t = now();
+		if (t >= end && stopped == 0) {
+			stopped = t;
+		}
+		if (stopped > 0 && (ld->answered == ld->sent || t > stopped + LOAD_DRAIN)) {
+			break;
+		}
+
+		long allowed = ld->rate > 0 ? (long) ((t - start) * ld->rate) - ld->sent
+			: ld->head < ld->tail ? ld->tail - ld->head : 0;
+		while (stopped == 0 && allowed-- > 0 && ld->head < ld->tail) {
+			int index = ld->ready[ld->head % ld->count];
+			struct link *k = &ld->links[ld->games[index].connection];
+			if (k->out + sizeof(struct server_request) > LOAD_BUFFER) {
+				break;
+			}
+			ld->head++;
+			send_step(ld, index);
+		}
+		for (int c = 0; c < ld->connections && ok == true; ++c) {
+			ok = flush(&ld->links[c]);
+		}
+
+		int wait = ld->rate > 0 && ld->head < ld->tail ? 1 : 10;  /* ms, the next request of the rate may be due */
+		int n = ok == true ? epoll_wait(epoll, events, 64, wait) : 0;
+		for (int i = 0; i < n && ok == true; ++i) {
+			ok = drain(ld, &ld->links[events[i].data.u32]);
+		}
+	}
+	res->elapsed = stopped - start;
+	res->sent = ld->sent;
+	if (ok == false) {
+		fprintf(stderr, "the server closed the connection\n");
+	}
+
+	for (int c = 0; c < ld->connections; ++c) {
+		close(ld->links[c].fd);
+	}
+	close(epoll);
+	return ok;
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	const char *path = SERVER_SOCKET;
+	int connections = 16;
+	long sessions = 3000;
+	double rate = 0, seconds = 5;
+	char list[64] = "3,4,5";
+	const char *mode = "random";
+	unsigned int seed = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "-p") == 0) {
+			path = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+			connections = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+			sessions = atol(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-r") == 0) {
+			rate = atof(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-d") == 0) {
+			seconds = atof(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-y") == 0) {
+			snprintf(list, sizeof(list), "%s", argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+			mode = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			seed = strtoul(argv[++i], NULL, 10);
+		} else {
+			fprintf(stderr, "usage: %s [-p socket] [-c connections] [-n sessions] [-r rate] [-d seconds] "
+				"[-y sizes] [-m random|corner] [-s seed]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	static struct load ld;
+	for (char *size = strtok(list, ","); size != NULL; size = strtok(NULL, ",")) {
+		if (ld.sizes == LOAD_MAX_SIZES) {
+			break;
+		}
+		ld.results[ld.sizes++].y = atoi(size);
+	}
+	bool sizes_ok = ld.sizes > 0;
+	for (int s = 0; s < ld.sizes; ++s) {
+		sizes_ok = sizes_ok && ld.results[s].y >= 3 && ld.results[s].y <= MAX_LENGTH;
+	}
+	ld.corner = strcmp(mode, "corner") == 0;
+	struct sockaddr_un address;
+	if (connections < 1 || sessions < connections || sessions / connections >= 65536 || rate < 0 || seconds <= 0
+		|| sizes_ok == false || (ld.corner == false && strcmp(mode, "random") != 0)
+		|| strlen(path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	/* the games shared between the connections, then every size alone */
+	ld.count = sessions;
+	ld.connections = connections;
+	ld.rate = rate;
+	ld.seconds = seconds;
+	ld.seed = seed;
+	ld.games = calloc(sessions, sizeof(struct game));
+	ld.ready = malloc(sessions * sizeof(int));
+	ld.links = calloc(connections, sizeof(struct link));
+	if (ld.games == NULL || ld.ready == NULL || ld.links == NULL) {
+		fprintf(stderr, "no memory for %ld sessions\n", sessions);
+		return 1;
+	}
+	for (int c = 0; c < connections; ++c) {
+		ld.links[c].games = malloc((sessions / connections + 1) * sizeof(int));
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+	for (int s = 0; s < ld.sizes; ++s) {
+		if (phase(&ld, s, &address) == false) {
+			return 1;
+		}
+	}
+
+	long sent = 0;
+	double elapsed = 0;
+	for (int s = 0; s < ld.sizes; ++s) {
+		sent += ld.results[s].sent;
+		elapsed += ld.results[s].elapsed;
+	}
+	printf("%d connections, %ld sessions, %s moves, %.1f s per size, ", connections, sessions, mode, seconds);
+	if (rate > 0) {
+		printf("rate %.0f req/s, achieved %.0f req/s\n", rate, sent / elapsed);
+	} else {
+		printf("rate unlimited, %.0f req/s\n", sent / elapsed);
+	}
+	printf("%4s %8s %7s %10s %10s %10s %9s %9s %9s %9s %6s\n", "size", "sessions", "games", "requests",
+		"req/s", "moves/s", "p50 us", "p99 us", "p999 us", "max us", "errors");
+	struct result total;
+	memset(&total, 0, sizeof(total));
+	for (int s = 0; s <= ld.sizes; ++s) {
+		struct result *r = s < ld.sizes ? &ld.results[s] : &total;
+		if (s < ld.sizes) {
+			total.sessions += r->sessions;
+			total.games += r->games;
+			total.requests += r->requests;
+			total.moves += r->moves;
+			total.errors += r->errors;
+			total.elapsed += r->elapsed;
+			for (int b = 0; b < LOAD_BUCKETS; ++b) {
+				total.latency.counts[b] += r->latency.counts[b];
+			}
+			total.latency.count += r->latency.count;
+			total.latency.max = r->latency.max > total.latency.max ? r->latency.max : total.latency.max;
+			printf("%dx%-2d", r->y, r->y);
+		} else {
+			printf("%4s", "all");
+		}
+		printf(" %8ld %7ld %10ld %10.0f %10.0f %9.1f %9.1f %9.1f %9.1f %6ld\n", r->sessions, r->games, r->requests,
+			r->requests / r->elapsed, r->moves / r->elapsed, percentile(&r->latency, 50), percentile(&r->latency, 99),
+			percentile(&r->latency, 99.9), r->latency.max / 1e3, r->errors);
+	}
+
+	for (int c = 0; c < connections; ++c) {
+		free(ld.links[c].games);
+	}
+	free(ld.links);
+	free(ld.games);
+	free(ld.ready);
+	return 0;
+}
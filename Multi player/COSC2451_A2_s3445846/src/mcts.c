@@ -0,0 +1,464 @@
+/** @file mcts.c
+ * @brief This file contains the Monte Carlo tree search player. Worker
+ * threads grow one shared tree: from the root they follow the move with
+ * the best UCT value, draw the new number like add_value() does, and
+ * finish the game with random moves when they reach a new board. A thread
+ * adds a virtual loss to the moves it follows, so the other threads
+ * prefer other branches until its result is known.
+ *
+ * After a move the part of the tree below the new board is kept: it is
+ * copied to the spare memory, which becomes the tree of the next move.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "key_algorithm.h"
+#include "rollout.h"
+#include "mcts.h"
+
+/** @brief Get the time in seconds.
+ * @return double
+ */
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/** @brief Take a node from the tree.
+ * @param t the tree
+ * @param board the board of the node
+ * @param key direction of a chance node, new number of a decision node
+ * @param gain score made by the move of a chance node
+ * @return the index of the node, -1 if the tree is full
+ */
+static int new_node(struct mcts *t, const unsigned char *board, int key, long long gain) {
+	int index = atomic_fetch_add(&t->used, 1);
+	if (index >= MCTS_NODES) {
+		return -1;
+	}
+
+	struct mcts_node *n = &t->nodes[index];
+	memcpy(n->board, board, t->y * t->y);
+	n->gain = gain;
+	n->key = key;
+	n->next = -1;
+	atomic_init(&n->first, -1);
+	atomic_init(&n->visits, 0);
+	atomic_init(&n->total, 0);
+	atomic_init(&n->virtual_loss, 0);
+	atomic_init(&n->expanded, false);
+	return index;
+}
+
+/** @brief Add a child in front of the children of a node. Only one thread
+ * adds nodes at a time, the others can read the children meanwhile.
+ * @param t the tree
+ * @param parent the parent node
+ * @param child the new node
+ * @return none
+ */
+static void link_child(struct mcts *t, int parent, int child) {
+	t->nodes[child].next = atomic_load(&t->nodes[parent].first);
+	atomic_store(&t->nodes[parent].first, child);
+}
+
+/** @brief Add the chance node of every possible move of a decision node.
+ * @param t the tree
+ * @param index the decision node
+ * @return false if the tree is full
+ */
+static bool expand(struct mcts *t, int index) {
+	struct mcts_node *n = &t->nodes[index];
+	const struct moves *m = get_moves(t->y);
+	bool ok = true;
+
+	pthread_mutex_lock(&t->grow);
+	if (atomic_load(&n->expanded) == false) {
+		if (atomic_load(&t->used) + 4 > MCTS_NODES) {
+			ok = false;
+		} else {
+			for (int d = 3; d >= 0; --d) {  /* linked in front, so the first child is MOVE_DOWN */
+				unsigned char clone[64];
+				long long score = 0;
+				int y = t->y;
+				memcpy(clone, n->board, y * y);
+				if (move_table(m, d, clone, &score, &y) == true) {
+					link_child(t, index, new_node(t, clone, d, score));
+				}
+			}
+			atomic_store(&n->expanded, true);
+		}
+	}
+	pthread_mutex_unlock(&t->grow);
+	return ok;
+}
+
+/** @brief Find the board with a given new number under a chance node, it is added if it is new.
+ * @param t the tree
+ * @param chance the chance node
+ * @param board the board with the new number
+ * @param key slot * 4 + exponent of the new number
+ * @param created true if the node was added
+ * @return the decision node, -1 if the tree is full
+ */
+static int spawn_child(struct mcts *t, int chance, const unsigned char *board, int key, bool *created) {
+	*created = false;
+	for (int c = atomic_load(&t->nodes[chance].first); c >= 0; c = t->nodes[c].next) {
+		if (t->nodes[c].key == key) {
+			return c;
+		}
+	}
+
+	pthread_mutex_lock(&t->grow);
+	int child = -1;
+	for (int c = atomic_load(&t->nodes[chance].first); c >= 0; c = t->nodes[c].next) {
+		if (t->nodes[c].key == key) {  /* another thread added it meanwhile */
+			child = c;
+			break;
+		}
+	}
+	if (child < 0) {
+		child = new_node(t, board, key, 0);
+		if (child >= 0) {
+			link_child(t, chance, child);
+			*created = true;
+		}
+	}
+	pthread_mutex_unlock(&t->grow);
+	return child;
+}
+
+/** @brief Choose the move to follow with UCT, counting the virtual losses.
+ * @param t the tree
+ * @param index the decision node
+ * @return the chance node, -1 if nothing can move
+ */
+static int select_child(struct mcts *t, int index) {
+	struct mcts_node *n = &t->nodes[index];
+	long visits = atomic_load(&n->visits);
+	double scale = visits > 0 ? (double) atomic_load(&n->total) / visits : 1;
+	double log_visits = log(visits + 1);
+	double largest = -DBL_MAX;
+	int best = -1;
+
+	if (scale < 1) {
+		scale = 1;
+	}
+	for (int c = atomic_load(&n->first); c >= 0; c = t->nodes[c].next) {
+		struct mcts_node *child = &t->nodes[c];
+		long v = atomic_load(&child->visits) + MCTS_VIRTUAL_LOSS * atomic_load(&child->virtual_loss);
+		double value = v == 0 ? DBL_MAX : (double) atomic_load(&child->total) / v
+			+ MCTS_EXPLORATION * scale * sqrt(log_visits / v);
+		if (value > largest) {
+			largest = value;
+			best = c;
+		}
+	}
+	return best;
+}
+
+/** @brief Follow the tree from the root to a new board, finish the game
+ * with random moves and add the score to every node of the path.
+ * @param t the tree
+ * @param seed random seed of the thread
+ * @return none
+ */
+static void iterate(struct mcts *t, unsigned int *seed) {
+	const struct moves *m = get_moves(t->y);
+	int y = t->y;
+	int path[MCTS_DEPTH];
+	int count = 0;
+	int node = t->root;
+	long long value = 0;
+	unsigned char board[64];
+
+	path[count++] = node;
+	while (true) {
+		if (atomic_load(&t->nodes[node].expanded) == false && expand(t, node) == false) {
+			memcpy(board, t->nodes[node].board, y * y);  /* the tree is full */
+			value = rollout_play(m, board, y, seed);
+			break;
+		}
+
+		int chance = select_child(t, node);
+		if (chance < 0) {  /* the game is over */
+			break;
+		}
+		atomic_fetch_add(&t->nodes[chance].virtual_loss, 1);
+		path[count++] = chance;
+
+		/* draw the new number like the game does */
+		bool isFail = false;
+		const unsigned char *after = t->nodes[chance].board;
+		memcpy(board, after, y * y);
+		add_value(board, &isFail, &y, seed);
+		int key = 0;
+		for (int i = 0; i < y * y; ++i) {
+			if (board[i] != after[i]) {
+				key = i * 4 + board[i];
+				break;
+			}
+		}
+
+		bool created;
+		int child = spawn_child(t, chance, board, key, &created);
+		if (child >= 0) {
+			path[count++] = child;
+		}
+		if (child < 0 || created == true || count + 2 > MCTS_DEPTH) {
+			value = rollout_play(m, board, y, seed);
+			break;
+		}
+		node = child;
+	}
+
+	/* the path alternates decision nodes (even) and chance nodes (odd) */
+	for (int i = count - 1; i >= 0; --i) {
+		struct mcts_node *n = &t->nodes[path[i]];
+		if (i % 2 == 1) {
+			value += n->gain;
+			atomic_fetch_sub(&n->virtual_loss, 1);
+		}
+		atomic_fetch_add(&n->total, value);
+		atomic_fetch_add(&n->visits, 1);
+	}
+}
+
+/** @brief Grow the tree for every decision until it is stopped.
+ * @param param the tree
+ * @return none
+ */
+static void *worker(void *param) {
+	struct mcts *t = param;
+	long seen = 0;
+
+	pthread_mutex_lock(&t->lock);
+	t->seed = t->seed * 1103515245u + 12345u;
+	unsigned int seed = t->seed;  /* every thread draws other numbers */
+
+	while (true) {
+		while (t->quit == false && (t->searching == false || t->job == seen)) {
+			pthread_cond_wait(&t->work, &t->lock);
+		}
+		if (t->quit == true) {
+			break;
+		}
+		seen = t->job;
+		t->busy++;
+		pthread_mutex_unlock(&t->lock);
+
+		while (atomic_load(&t->stop) == false) {
+			iterate(t, &seed);
+			atomic_fetch_add(&t->iterations, 1);
+		}
+
+		pthread_mutex_lock(&t->lock);
+		t->busy--;
+		pthread_cond_signal(&t->idle);
+	}
+
+	pthread_mutex_unlock(&t->lock);
+	return NULL;
+}
+
+/** @brief Copy a node and everything below it to the spare memory.
+ * @param t the tree
+ * @param from the node
+ * @param used number of nodes copied so far
+ * @return the index of the copy
+ */
+static int copy_tree(struct mcts *t, int from, int *used) {
+	const struct mcts_node *src = &t->nodes[from];
+	int index = (*used)++;
+	struct mcts_node *dst = &t->spare[index];
+	int last = -1;
+
+	memcpy(dst->board, src->board, t->y * t->y);
+	dst->gain = src->gain;
+	dst->key = src->key;
+	dst->next = -1;
+	atomic_init(&dst->first, -1);
+	atomic_init(&dst->visits, atomic_load(&src->visits));
+	atomic_init(&dst->total, atomic_load(&src->total));
+	atomic_init(&dst->virtual_loss, 0);
+	atomic_init(&dst->expanded, atomic_load(&src->expanded));
+
+	for (int c = atomic_load(&src->first); c >= 0; c = t->nodes[c].next) {
+		int copy = copy_tree(t, c, used);
+		if (last < 0) {
+			atomic_init(&t->spare[index].first, copy);
+		} else {
+			t->spare[last].next = copy;
+		}
+		last = copy;
+	}
+	return index;
+}
+
+/** @brief Find the board under the move played last time.
+ * @param t the tree
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the decision node, -1 if it is not in the tree
+ */
+static int find_root(struct mcts *t, const unsigned char *a, int y) {
+	if (t->root < 0 || t->chosen < 0 || t->y != y) {
+		return -1;
+	}
+	for (int c = atomic_load(&t->nodes[t->root].first); c >= 0; c = t->nodes[c].next) {
+		if (t->nodes[c].key != t->chosen) {
+			continue;
+		}
+		for (int d = atomic_load(&t->nodes[c].first); d >= 0; d = t->nodes[d].next) {
+			if (memcmp(t->nodes[d].board, a, y * y) == 0) {
+				return d;
+			}
+		}
+	}
+	return -1;
+}
+
+/** @brief Allocate the trees and start the worker threads.
+ * @param threads number of threads
+ * @param budget_ms time to decide a move, in milliseconds
+ * @param seed random seed of the search
+ * @return the tree, NULL if there is no memory
+ */
+struct mcts *mcts_start(int threads, int budget_ms, unsigned int seed) {
+	struct mcts *t = calloc(1, sizeof(struct mcts));
+	if (t == NULL) {
+		return NULL;
+	}
+	t->nodes = malloc(MCTS_NODES * sizeof(struct mcts_node));
+	t->spare = malloc(MCTS_NODES * sizeof(struct mcts_node));
+	t->workers = malloc(threads * sizeof(pthread_t));
+	if (t->nodes == NULL || t->spare == NULL || t->workers == NULL) {
+		free(t->nodes);
+		free(t->spare);
+		free(t->workers);
+		free(t);
+		return NULL;
+	}
+
+	t->threads = threads;
+	t->budget_ms = budget_ms;
+	t->seed = seed;
+	t->root = -1;
+	t->chosen = -1;
+	atomic_init(&t->used, 0);
+	atomic_init(&t->stop, true);
+	atomic_init(&t->iterations, 0);
+	pthread_mutex_init(&t->lock, NULL);
+	pthread_mutex_init(&t->grow, NULL);
+	pthread_cond_init(&t->work, NULL);
+	pthread_cond_init(&t->idle, NULL);
+	for (int i = 0; i < threads; ++i) {
+		pthread_create(&t->workers[i], NULL, worker, t);
+	}
+	return t;
+}
+
+/** @brief Grow the tree for the time budget and choose the most visited move.
+ * @param t the tree
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @param report summary of the decision, can be NULL
+ * @return the direction, -1 if nothing can move
+ */
+int mcts_choose(struct mcts *t, const unsigned char *a, int y, struct mcts_report *report) {
+	double start = now();
+	long reused = 0;
+
+	pthread_mutex_lock(&t->lock);
+	int root = find_root(t, a, y);
+	if (root >= 0) {  /* keep what was learned about this board */
+		int used = 0;
+		copy_tree(t, root, &used);
+		struct mcts_node *swap = t->nodes;
+		t->nodes = t->spare;
+		t->spare = swap;
+		atomic_store(&t->used, used);
+		t->root = 0;
+		reused = atomic_load(&t->nodes[0].visits);
+	} else {
+		t->y = y;
+		atomic_store(&t->used, 0);
+		t->root = new_node(t, a, 0, 0);
+	}
+
+	atomic_store(&t->iterations, 0);
+	t->job++;
+	t->searching = true;
+	atomic_store(&t->stop, false);
+	pthread_cond_broadcast(&t->work);
+	pthread_mutex_unlock(&t->lock);
+
+	usleep(t->budget_ms * 1000);
+
+	pthread_mutex_lock(&t->lock);
+	atomic_store(&t->stop, true);
+	t->searching = false;
+	while (t->busy > 0) {
+		pthread_cond_wait(&t->idle, &t->lock);
+	}
+
+	/* the most visited move is the most reliable */
+	int best = -1;
+	long most = -1;
+	for (int c = atomic_load(&t->nodes[t->root].first); c >= 0; c = t->nodes[c].next) {
+		if (atomic_load(&t->nodes[c].visits) > most) {
+			most = atomic_load(&t->nodes[c].visits);
+			best = t->nodes[c].key;
+		}
+	}
+	if (best < 0) {  /* the tree was too full to expand the root */
+		unsigned char clone[64];
+		for (int d = 0; d < 4 && best < 0; ++d) {
+			long long score = 0;
+			memcpy(clone, a, y * y);
+			if (move_table(get_moves(y), d, clone, &score, &y) == true) {
+				best = d;
+			}
+		}
+	}
+	t->chosen = best;
+	pthread_mutex_unlock(&t->lock);
+
+	if (report != NULL) {
+		int used = atomic_load(&t->used);
+		report->iterations = atomic_load(&t->iterations);
+		report->nodes = used < MCTS_NODES ? used : MCTS_NODES;
+		report->reused = reused;
+		report->ms = (now() - start) * 1000;
+	}
+	return best;
+}
+
+/** @brief Stop the worker threads and free the trees.
+ * @param t the tree
+ * @return none
+ */
+void mcts_stop(struct mcts *t) {
+	pthread_mutex_lock(&t->lock);
+	t->quit = true;
+	pthread_cond_broadcast(&t->work);
+	pthread_mutex_unlock(&t->lock);
+
+	for (int i = 0; i < t->threads; ++i) {
+		pthread_join(t->workers[i], NULL);
+	}
+	pthread_mutex_destroy(&t->lock);
+	pthread_mutex_destroy(&t->grow);
+	pthread_cond_destroy(&t->work);
+	pthread_cond_destroy(&t->idle);
+	free(t->nodes);
+	free(t->spare);
+	free(t->workers);
+	free(t);
+}
@@ -0,0 +1,40 @@
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define MCTS_NODES (1 << 17)  /* nodes of the tree, 2 trees are kept for the reuse */
+#define MCTS_EXPLORATION 0.5  /* weight of the exploration in UCT, relative to the mean score */
+#define MCTS_VIRTUAL_LOSS 3  /* visits without score added to a move while a thread searches it */
+#define MCTS_DEPTH 256  /* longest path from the root, a rollout continues the game */
+
+/** @struct Node of the tree. A decision node is a board where the AI moves,
+ * its children are the chance nodes of its moves; a chance node is the
+ * board after a move, its children are the boards with a new number.
+ * Nodes are linked by their index in the tree, -1 is no node.
+ */
+struct mcts_node {
+	unsigned char board[64]; long long gain;  /* gain: score made by the move of a chance node */
+	int key; int next; atomic_int first;  /* key: direction or slot * 4 + exponent of the new number */
+	atomic_long visits; atomic_llong total; atomic_int virtual_loss;
+	atomic_bool expanded;
+};
+
+/** @struct Summary of one decision.
+ */
+struct mcts_report {
+	long iterations; long nodes; long reused; double ms;  /* reused: visits kept from the last move */
+};
+
+/** @struct Tree shared by the worker threads, and the threads.
+ */
+struct mcts {
+	int threads; int budget_ms; unsigned int seed; pthread_t *workers;
+	pthread_mutex_t lock; pthread_cond_t work; pthread_cond_t idle; pthread_mutex_t grow;  /* grow: adding nodes */
+	struct mcts_node *nodes; struct mcts_node *spare;  /* the tree and the memory of the next one */
+	atomic_int used; int root; int y; int chosen;  /* chosen: last move, to find the next root */
+	long job; bool searching; bool quit; int busy; atomic_bool stop; atomic_long iterations;
+};
+
+struct mcts *mcts_start(int threads, int budget_ms, unsigned int seed);
+int mcts_choose(struct mcts *t, const unsigned char *a, int y, struct mcts_report *report);
+void mcts_stop(struct mcts *t);
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include "menu.h"
+#include "score.h"
 
 /** @brief This function controls player's input.
  * @return none 
@@ -98,7 +99,7 @@ void print_option(int choice) {
  */
 void print_score(int current_screen) {
 
-    FILE *f = fopen("score.sav", "r"); /* Open file to read data */  
+    FILE *f = fopen(SCORE_FILE, "r"); /* Open file to read data, the verified scores only */  
 
     if (!f) { 
         print_mess(0, "Data is not existed!"); /* File is not existed */        
@@ -114,10 +115,10 @@ void print_score(int current_screen) {
 
 	        } else {
 	        	char name[10];
-	        	int score;
+	        	long long score;
 	        	char date[20];
-	        	fscanf(f,"%s %u %s\n", name, &score, date); /* Scan for data */        	
-	        	mvprintw(maxy/4 + i, maxx/3, "%2u. %s\t%u\t%s", i + 1, name, score, date); /* Print scores in the center of screen */       	        	
+	        	fscanf(f,"%s %lld %s\n", name, &score, date); /* Scan for data */        	
+	        	mvprintw(maxy/4 + i, maxx/3, "%2u. %s\t%lld\t%s", i + 1, name, score, date); /* Print scores in the center of screen */       	        	
 	        }       
 	    }	    	
 	    fclose(f);
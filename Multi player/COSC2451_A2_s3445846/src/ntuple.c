@@ -0,0 +1,363 @@
+/** @file ntuple.c
+ * @brief This file contains the n-tuple network that scores a game board
+ * for the AI. The weights are learned by self-play (see train.c) and kept
+ * in a binary file that is mapped into memory, so even tables of hundreds
+ * of MB load instantly and are shared by every process using them.
+ * The weights can also be stored as 16 or 8 bit integers with a scale per
+ * tuple: the tables are 2 or 4 times smaller, so more of them stay in cache.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "ntuple.h"
+
+/* default tuples as (row, column) pairs: two rows of 4 + 2 and two
+ * 2 x 3 rectangles, the smaller board only gets the rectangles */
+static const unsigned char default_shapes[4][NTUPLE_MAX_CELLS][2] = {
+	{{0, 0}, {0, 1}, {0, 2}, {1, 0}, {1, 1}, {1, 2}},
+	{{1, 0}, {1, 1}, {1, 2}, {2, 0}, {2, 1}, {2, 2}},
+	{{0, 0}, {0, 1}, {0, 2}, {0, 3}, {1, 0}, {1, 1}},
+	{{1, 0}, {1, 1}, {1, 2}, {1, 3}, {2, 0}, {2, 1}}
+};
+
+/** @brief Find the slots of every tuple in the 8 symmetries of the board
+ * and the place of its weights.
+ * @param n the network, y, count, length and cells are set
+ * @return none
+ */
+static void ntuple_layout(struct ntuple *n) {
+	int y = n->y;
+
+	n->total = 0;
+	for (int t = 0; t < n->count; ++t) {
+		for (int s = 0; s < NTUPLE_SYMMETRIES; ++s) {
+			for (int k = 0; k < n->length[t]; ++k) {
+				int r = n->cells[t][k] / y, c = n->cells[t][k] % y;
+				if (s & 1) {  /* mirror left to right */
+					c = y - 1 - c;
+				}
+				if (s & 2) {  /* mirror top to bottom */
+					r = y - 1 - r;
+				}
+				if (s & 4) {  /* swap rows and columns */
+					int temp = r;
+					r = c;
+					c = temp;
+				}
+				n->positions[t][s][k] = r * y + c;
+			}
+		}
+		n->offset[t] = n->total;
+		n->total += (size_t) 1 << (4 * n->length[t]);
+	}
+	n->weights = NULL;
+	n->weights16 = NULL;
+	n->weights8 = NULL;
+	n->memory = NULL;
+	n->size = 0;
+	n->mapped = false;
+}
+
+/** @brief Get the size of a weight.
+ * @param format NTUPLE_FLOAT, NTUPLE_INT16 or NTUPLE_INT8
+ * @return number of bytes
+ */
+static size_t weight_size(int format) {
+	return format == NTUPLE_FLOAT ? sizeof(float) : format == NTUPLE_INT16 ? sizeof(short) : 1;
+}
+
+/** @brief Point the network to its weights.
+ * @param n the network
+ * @param weights the first weight, of the format of the network
+ * @return none
+ */
+static void ntuple_attach(struct ntuple *n, void *weights) {
+	n->weights = n->format == NTUPLE_FLOAT ? weights : NULL;
+	n->weights16 = n->format == NTUPLE_INT16 ? weights : NULL;
+	n->weights8 = n->format == NTUPLE_INT8 ? weights : NULL;
+}
+
+/** @brief Set the tuples of a network.
+ * @param n the network
+ * @param y colum length of game board
+ * @param spec tuples separated by '/', each a list of slot indexes
+ * separated by ',' (e.g. "0,1,2,3/4,5,6,7"), NULL for the default tuples
+ * @return false if the tuples are not valid for the board size
+ */
+bool ntuple_parse(struct ntuple *n, int y, const char *spec) {
+	memset(n, 0, sizeof(*n));
+	n->y = y;
+
+	if (spec == NULL) {
+		n->count = y < 4 ? 2 : 4;
+		for (int t = 0; t < n->count; ++t) {
+			n->length[t] = NTUPLE_MAX_CELLS;
+			for (int k = 0; k < NTUPLE_MAX_CELLS; ++k) {
+				n->cells[t][k] = default_shapes[t][k][0] * y + default_shapes[t][k][1];
+			}
+		}
+	} else {
+		const char *p = spec;
+		n->count = 1;
+		while (*p != '\0') {
+			char *end;
+			long cell = strtol(p, &end, 10);
+			int t = n->count - 1;
+			if (end == p || cell < 0 || cell >= y * y || n->length[t] == NTUPLE_MAX_CELLS) {
+				return false;
+			}
+			n->cells[t][n->length[t]++] = cell;
+
+			if (*end == '/') {
+				if (n->count == NTUPLE_MAX_TUPLES) {
+					return false;
+				}
+				n->count++;
+			} else if (*end != ',' && *end != '\0') {
+				return false;
+			}
+			p = *end == '\0' ? end : end + 1;
+		}
+		for (int t = 0; t < n->count; ++t) {
+			if (n->length[t] == 0) {
+				return false;
+			}
+		}
+	}
+
+	ntuple_layout(n);
+	return true;
+}
+
+/** @brief Allocate the weights of a network, all set to 0.
+ * @param n the network set by ntuple_parse()
+ * @return false if there is no memory
+ */
+bool ntuple_create(struct ntuple *n) {
+	n->weights = calloc(n->total, sizeof(float));
+	n->memory = n->weights;
+	n->size = n->total * sizeof(float);
+	n->mapped = false;
+	return n->weights != NULL;
+}
+
+/** @brief Convert float weights to integers. Each tuple gets the scale
+ * that maps its biggest weight to the biggest integer.
+ * @param n the network with float weights
+ * @param format NTUPLE_INT16 or NTUPLE_INT8
+ * @param q the quantized network, to close with ntuple_close()
+ * @return false if there is no memory
+ */
+bool ntuple_quantize(const struct ntuple *n, int format, struct ntuple *q) {
+	int limit = format == NTUPLE_INT16 ? 32767 : 127;
+
+	*q = *n;
+	q->format = format;
+	q->mapped = false;
+	q->memory = malloc(n->total * weight_size(format));
+	q->size = n->total * weight_size(format);
+	if (q->memory == NULL) {
+		return false;
+	}
+	ntuple_attach(q, q->memory);
+
+	for (int t = 0; t < n->count; ++t) {
+		const float *w = n->weights + n->offset[t];
+		size_t count = (size_t) 1 << (4 * n->length[t]);
+		float largest = 0;
+		for (size_t i = 0; i < count; ++i) {
+			if (fabsf(w[i]) > largest) {
+				largest = fabsf(w[i]);
+			}
+		}
+		q->scale[t] = largest > 0 ? largest / limit : 1;
+
+		for (size_t i = 0; i < count; ++i) {
+			long value = lrintf(w[i] / q->scale[t]);
+			value = value > limit ? limit : value < -limit ? -limit : value;
+			if (format == NTUPLE_INT16) {
+				q->weights16[n->offset[t] + i] = value;
+			} else {
+				q->weights8[n->offset[t] + i] = value;
+			}
+		}
+	}
+	return true;
+}
+
+/** @brief Map a weights file into memory.
+ * @param n the network
+ * @param path the weights file
+ * @param writable true to change the weights in memory (the file is not changed)
+ * @return false if the file cannot be read or is not valid
+ */
+bool ntuple_open(struct ntuple *n, const char *path, bool writable) {
+	struct ntuple_header h;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	bool ok = pread(fd, &h, sizeof(h), 0) == sizeof(h) && memcmp(h.magic, "NTUP", 4) == 0
+		&& (h.version == 1 || h.version == NTUPLE_VERSION) && h.y >= 3 && h.y * h.y <= 64
+		&& h.count >= 1 && h.count <= NTUPLE_MAX_TUPLES;
+	if (ok == true && h.version == 1) {  /* the rest of the page was left empty */
+		h.format = NTUPLE_FLOAT;
+	}
+	ok = ok && h.format >= NTUPLE_FLOAT && h.format <= NTUPLE_INT8;
+	for (int t = 0; ok && t < h.count; ++t) {
+		ok = h.length[t] >= 1 && h.length[t] <= NTUPLE_MAX_CELLS;
+		for (int k = 0; ok && k < h.length[t]; ++k) {
+			ok = h.cells[t][k] < h.y * h.y;
+		}
+	}
+	if (ok == false) {
+		close(fd);
+		return false;
+	}
+
+	memset(n, 0, sizeof(*n));
+	n->y = h.y;
+	n->count = h.count;
+	memcpy(n->length, h.length, sizeof(h.length));
+	memcpy(n->cells, h.cells, sizeof(h.cells));
+	n->format = h.format;
+	memcpy(n->scale, h.scale, sizeof(h.scale));
+	ntuple_layout(n);
+
+	size_t size = NTUPLE_HEADER_SIZE + n->total * weight_size(n->format);
+	void *memory = MAP_FAILED;
+	if (lseek(fd, 0, SEEK_END) == (off_t) size) {
+		memory = mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+			writable ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+	}
+	close(fd);  /* the mapping stays valid after closing the file */
+	if (memory == MAP_FAILED) {
+		return false;
+	}
+
+	n->memory = memory;
+	n->size = size;
+	n->mapped = true;
+	ntuple_attach(n, (char *) memory + NTUPLE_HEADER_SIZE);
+	return true;
+}
+
+/** @brief Write the weights file. It is written next to the old one and
+ * then renamed, so processes that mapped the old file are not disturbed.
+ * @param n the network
+ * @param path the weights file
+ * @return false if the file cannot be written
+ */
+bool ntuple_save(const struct ntuple *n, const char *path) {
+	char temp[512];
+	snprintf(temp, sizeof(temp), "%s.tmp", path);
+	FILE *f = fopen(temp, "wb");
+	if (!f) {
+		return false;
+	}
+
+	static char page[NTUPLE_HEADER_SIZE];
+	struct ntuple_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, "NTUP", 4);
+	h.version = NTUPLE_VERSION;
+	h.y = n->y;
+	h.count = n->count;
+	memcpy(h.length, n->length, sizeof(h.length));
+	memcpy(h.cells, n->cells, sizeof(h.cells));
+	h.format = n->format;
+	memcpy(h.scale, n->scale, sizeof(h.scale));
+	memset(page, 0, sizeof(page));
+	memcpy(page, &h, sizeof(h));
+
+	const void *weights = n->format == NTUPLE_FLOAT ? (const void *) n->weights
+		: n->format == NTUPLE_INT16 ? (const void *) n->weights16 : (const void *) n->weights8;
+	bool ok = fwrite(page, sizeof(page), 1, f) == 1
+		&& fwrite(weights, weight_size(n->format), n->total, f) == n->total;
+	if (fclose(f) != 0 || ok == false) {
+		remove(temp);
+		return false;
+	}
+	return rename(temp, path) == 0;
+}
+
+/** @brief Free or unmap the weights of a network.
+ * @param n the network
+ * @return none
+ */
+void ntuple_close(struct ntuple *n) {
+	if (n->mapped == true) {
+		munmap(n->memory, n->size);
+	} else {
+		free(n->memory);
+	}
+	n->memory = NULL;
+	ntuple_attach(n, NULL);
+}
+
+/** @brief Find the weights used to score a board.
+ * @param n the network
+ * @param a the exponents of the game board
+ * @param index the position of every weight in n->weights
+ * (room for NTUPLE_MAX_INDEXES values)
+ * @return the number of weights
+ */
+int ntuple_indexes(const struct ntuple *n, const unsigned char *a, size_t *index) {
+	unsigned char b[64];
+	int count = 0;
+
+	for (int i = 0; i < n->y * n->y; ++i) {
+		b[i] = a[i] > 15 ? 15 : a[i];
+	}
+	for (int t = 0; t < n->count; ++t) {
+		for (int s = 0; s < NTUPLE_SYMMETRIES; ++s) {
+			const unsigned char *pos = n->positions[t][s];
+			size_t key = 0;
+			for (int k = 0; k < n->length[t]; ++k) {
+				key |= (size_t) b[pos[k]] << (4 * k);
+			}
+			index[count++] = n->offset[t] + key;
+		}
+	}
+	return count;
+}
+
+/** @brief Score a game board: the expected score of the rest of the game.
+ * @param n the network
+ * @param a the exponents of the game board
+ * @return float
+ */
+float ntuple_eval(const struct ntuple *n, const unsigned char *a) {
+	size_t index[NTUPLE_MAX_INDEXES];
+	int count = ntuple_indexes(n, a, index);
+	float score = 0;
+
+	if (n->format == NTUPLE_FLOAT) {
+		for (int i = 0; i < count; ++i) {
+			score += n->weights[index[i]];
+		}
+		return score;
+	}
+
+	/* the 8 symmetries of a tuple share its scale, add them as integers first */
+	for (int t = 0, i = 0; t < n->count; ++t) {
+		int sum = 0;
+		if (n->format == NTUPLE_INT16) {
+			for (int s = 0; s < NTUPLE_SYMMETRIES; ++s, ++i) {
+				sum += n->weights16[index[i]];
+			}
+		} else {
+			for (int s = 0; s < NTUPLE_SYMMETRIES; ++s, ++i) {
+				sum += n->weights8[index[i]];
+			}
+		}
+		score += sum * n->scale[t];
+	}
+	return score;
+}
@@ -0,0 +1,47 @@
+#include <stdbool.h>
+#include <stddef.h>
+
+#define NTUPLE_FILE "ntuple.weights"
+#define NTUPLE_QUANTIZED_FILE "ntuple.q.weights"  /* preferred by the AI when it exists */
+#define NTUPLE_VERSION 2
+#define NTUPLE_MAX_TUPLES 16
+#define NTUPLE_MAX_CELLS 6  /* a tuple of 6 slots has 16^6 weights */
+#define NTUPLE_SYMMETRIES 8  /* rotations and reflections of the board */
+#define NTUPLE_MAX_INDEXES (NTUPLE_MAX_TUPLES * NTUPLE_SYMMETRIES)
+#define NTUPLE_HEADER_SIZE 4096  /* the weights start on their own page */
+
+/* types of the weights */
+enum { NTUPLE_FLOAT, NTUPLE_INT16, NTUPLE_INT8 };
+
+/** @struct Header of the weights file, followed by the weights of
+ * every tuple one after the other.
+ */
+struct ntuple_header {
+	char magic[4]; int version; int y; int count;
+	int length[NTUPLE_MAX_TUPLES]; unsigned char cells[NTUPLE_MAX_TUPLES][NTUPLE_MAX_CELLS];
+	int format; float scale[NTUPLE_MAX_TUPLES];  /* version 2, files of version 1 hold floats */
+};
+
+/** @struct N-tuple network: each tuple is a set of slots whose exponents
+ * (4 bits each, bigger ones count as 15) index a table of weights. Every
+ * tuple is also read in the 8 symmetries of the board with the same weights.
+ * Quantized weights are integers, the weight of tuple t is scale[t] times the integer.
+ */
+struct ntuple {
+	int y; int count;
+	int length[NTUPLE_MAX_TUPLES]; unsigned char cells[NTUPLE_MAX_TUPLES][NTUPLE_MAX_CELLS];
+	unsigned char positions[NTUPLE_MAX_TUPLES][NTUPLE_SYMMETRIES][NTUPLE_MAX_CELLS];
+	size_t offset[NTUPLE_MAX_TUPLES]; size_t total;  /* number of weights */
+	int format; float scale[NTUPLE_MAX_TUPLES];
+	float *weights; short *weights16; signed char *weights8;  /* only the one of the format is set */
+	void *memory; size_t size; bool mapped;
+};
+
+bool ntuple_parse(struct ntuple *n, int y, const char *spec);
+bool ntuple_create(struct ntuple *n);
+bool ntuple_quantize(const struct ntuple *n, int format, struct ntuple *q);
+bool ntuple_open(struct ntuple *n, const char *path, bool writable);
+bool ntuple_save(const struct ntuple *n, const char *path);
+void ntuple_close(struct ntuple *n);
+int ntuple_indexes(const struct ntuple *n, const unsigned char *a, size_t *index);
+float ntuple_eval(const struct ntuple *n, const unsigned char *a);
@@ -0,0 +1,153 @@
+/** @file quantize.c
+ * @brief This program converts the float weights written by train to
+ * 16 or 8 bit integers, then compares both networks: evaluations per
+ * second on boards of real games and the scores of games played with each.
+ *
+ * Usage: ./quantize [-b 16|8] [-g games] [-s seed] [input [output]]
+ * (default: -b 16 ntuple.weights ntuple.q.weights)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "key_algorithm.h"
+#include "ntuple.h"
+#include "rng.h"
+#include "sim.h"
+#include "ai.h"
+
+#define SAMPLE_BOARDS 65536
+
+/** @struct Policy of the AI that keeps the boards it sees.
+ */
+struct recorder {
+	struct ntuple *n; unsigned char *boards; long count;
+};
+
+/** @brief Get the time in seconds.
+ * @return double
+ */
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/** @brief Choose a move with ai_ntuple() and keep the board.
+ * @param ctx the recorder
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction
+ */
+static int record(void *ctx, const unsigned char *a, int y) {
+	struct recorder *r = ctx;
+	if (r->count < SAMPLE_BOARDS) {
+		memcpy(r->boards + r->count * y * y, a, y * y);
+		r->count++;
+	}
+	return ai_ntuple(r->n, a, y);
+}
+
+/** @brief Measure a network and print one line.
+ * @param name name of the format
+ * @param n the network
+ * @param boards the sample boards
+ * @param count number of boards
+ * @param games number of games to play
+ * @param seed seed of the games
+ * @return none
+ */
+static void compare(const char *name, struct ntuple *n, const unsigned char *boards, long count,
+	int games, unsigned int seed) {
+	int y = n->y;
+	long evals = 0;
+	volatile float sink = 0;
+	double start = now(), elapsed = 0;
+	while (elapsed < 1.0) {
+		for (long i = 0; i < count; ++i) {
+			sink += ntuple_eval(n, boards + i * y * y);
+		}
+		evals += count;
+		elapsed = now() - start;
+	}
+
+	double total = 0;
+	long reach2048 = 0;
+	for (int g = 0; g < games; ++g) {
+		struct game_result r;
+		sim_play(y, rng_stream(seed, 0, g), ai_ntuple, n, &r);
+		total += r.score;
+		reach2048 += r.max_tile >= 11;
+	}
+
+	printf("%-6s %10.1f %14.0f %12.1f %8.1f%%\n", name, n->size / 1048576.0, evals / elapsed,
+		total / games, 100.0 * reach2048 / games);
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	int bits = 16, games = 100;
+	unsigned int seed = 1;
+	const char *files[2] = {NTUPLE_FILE, NTUPLE_QUANTIZED_FILE};
+	int count = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "-b") == 0) {
+			bits = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-g") == 0) {
+			games = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			seed = strtoul(argv[++i], NULL, 10);
+		} else if (argv[i][0] != '-' && count < 2) {
+			files[count++] = argv[i];
+		} else {
+			fprintf(stderr, "usage: %s [-b 16|8] [-g games] [-s seed] [input [output]]\n", argv[0]);
+			return 1;
+		}
+	}
+	if ((bits != 16 && bits != 8) || games < 0) {
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	struct ntuple n, q;
+	if (ntuple_open(&n, files[0], false) == false || n.format != NTUPLE_FLOAT) {
+		fprintf(stderr, "%s is not a file of float weights\n", files[0]);
+		return 1;
+	}
+	if (ntuple_quantize(&n, bits == 16 ? NTUPLE_INT16 : NTUPLE_INT8, &q) == false) {
+		fprintf(stderr, "no memory\n");
+		return 1;
+	}
+	if (ntuple_save(&q, files[1]) == false) {
+		fprintf(stderr, "cannot write %s\n", files[1]);
+		return 1;
+	}
+	printf("wrote %s\n", files[1]);
+
+	if (games > 0) {
+		/* sample the boards the float network meets in its games */
+		struct recorder r = {&n, malloc(SAMPLE_BOARDS * n.y * n.y), 0};
+		for (int g = 0; r.count < SAMPLE_BOARDS && g < games; ++g) {
+			struct game_result result;
+			sim_play(n.y, rng_stream(seed, 1, g), record, &r, &result);
+		}
+
+		printf("%-6s %10s %14s %12s %9s\n", "format", "MB", "evals/sec", "mean score", "2048%");
+		compare("float", &n, r.boards, r.count, games, seed);
+		compare(bits == 16 ? "int16" : "int8", &q, r.boards, r.count, games, seed);
+		free(r.boards);
+	}
+
+	ntuple_close(&q);
+	ntuple_close(&n);
+	return 0;
+}
@@ -0,0 +1,145 @@
+/** @file replay.c
+ * @brief This file reads, writes and checks replays. A replay only keeps
+ * the moves: the new numbers are drawn again from the random numbers of
+ * the game, so the boards the moves are checked on are the ones the
+ * player saw, and a move that does not change the board, or a score that
+ * the moves do not make, is found.
+ * A replay is one line of text:
+ * replay 1 <name> <size> <seed> <game> <score> <moves, d u l r or ->
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+#include "key_algorithm.h"
+#include "rng.h"
+#include "replay.h"
+
+static const char letters[4] = {'d', 'u', 'l', 'r'};  /* MOVE_DOWN, MOVE_UP, MOVE_LEFT, MOVE_RIGHT */
+
+/** @brief Read the next replay of a file, replay_free() frees its moves.
+ * The file is read line by line, so a line that is not a replay is read
+ * as a malformed replay and the next line is read as usual.
+ * @param f the file
+ * @param r the replay
+ * @return false at the end of the file
+ */
+bool replay_read(FILE *f, struct replay *r) {
+	char *line = NULL;
+	size_t capacity = 0;
+	ssize_t length;
+	int version, name = 0, end = 0, used = 0;
+	memset(r, 0, sizeof(*r));
+	do {  /* blank lines are not replays */
+		length = getline(&line, &capacity, f);
+		for (used = 0; used < length && isspace((unsigned char) line[used]); ++used) {
+			continue;
+		}
+	} while (length >= 0 && used == length);
+	if (length < 0) {
+		free(line);
+		return false;
+	}
+
+	r->malformed = sscanf(line, " replay %d %n%5s%n %d %u %ld %lld %n", &version, &name, r->name, &end, &r->y,
+		&r->seed, &r->game, &r->score, &used) != 6 || version != REPLAY_VERSION
+		|| end - name < 1 || isspace((unsigned char) line[end]) == 0;  /* a longer name does not fit */
+	r->moves = r->malformed == true ? NULL : malloc(length + 1);
+	r->malformed = r->malformed == true || r->moves == NULL;
+	long i = used;
+	for (; i < length && r->malformed == false && isspace((unsigned char) line[i]) == 0; ++i) {
+		const char *letter = memchr(letters, line[i], sizeof(letters));
+		if (line[i] == '-' && r->count == 0) {
+			continue;  /* no move */
+		}
+		if (letter == NULL) {
+			r->malformed = true;
+		} else {
+			r->moves[r->count++] = letter - letters;
+		}
+	}
+	for (; i < length && r->malformed == false; ++i) {  /* nothing but spaces after the moves */
+		r->malformed = isspace((unsigned char) line[i]) == 0;
+	}
+	if (r->malformed == true) {
+		replay_free(r);
+	}
+	free(line);
+	return true;
+}
+
+/** @brief Write a replay as one line.
+ * @param f the file
+ * @param r the replay
+ * @return none
+ */
+void replay_write(FILE *f, const struct replay *r) {
+	fprintf(f, "replay %d %s %d %u %ld %lld ", REPLAY_VERSION, r->name, r->y, r->seed, r->game, r->score);
+	if (r->count == 0) {
+		putc('-', f);
+	}
+	for (long i = 0; i < r->count; ++i) {
+		putc(letters[r->moves[i]], f);
+	}
+	putc('\n', f);
+}
+
+/** @brief Free the moves of a replay.
+ * @param r the replay
+ * @return none
+ */
+void replay_free(struct replay *r) {
+	free(r->moves);
+	r->moves = NULL;
+	r->count = 0;
+}
+
+/** @brief Play a replay again from its random numbers: every move must
+ * change the board, then the new number is the one of add_value_at(),
+ * and the score made by the moves must be the score of the replay.
+ * @param r the replay
+ * @param move the index of the first illegal move, can be NULL
+ * @param score the score made by the moves, can be NULL
+ * @return REPLAY_VALID, REPLAY_ILLEGAL, REPLAY_SCORE, REPLAY_SIZE or REPLAY_FORMAT
+ */
+int replay_verify(const struct replay *r, long *move, long long *score) {
+	unsigned char table[MAX_LENGTH * MAX_LENGTH];
+	struct rng_stream stream = rng_stream(r->seed, 0, r->game);
+	long long made = 0;
+	bool isFail = false;
+	int y = r->y;
+
+	if (move != NULL) {
+		*move = -1;
+	}
+	if (score != NULL) {
+		*score = 0;
+	}
+	if (r->malformed == true) {
+		return REPLAY_FORMAT;
+	}
+	if (y < 3 || y > MAX_LENGTH) {
+		return REPLAY_SIZE;
+	}
+	const struct moves *moves = get_moves(y);
+	memset(table, 0, sizeof(table));
+	add_value_at(table, &isFail, &y, &stream, 0);
+	add_value_at(table, &isFail, &y, &stream, 1);
+
+	for (long i = 0; i < r->count; ++i) {
+		if (move_table(moves, r->moves[i], table, &made, &y) == false) {
+			if (move != NULL) {
+				*move = i;
+			}
+			return REPLAY_ILLEGAL;
+		}
+		add_value_at(table, &isFail, &y, &stream, i + 2);  /* the spawn after move k is k + 1 */
+	}
+	if (score != NULL) {
+		*score = made;
+	}
+	return made == r->score ? REPLAY_VALID : REPLAY_SCORE;
+}
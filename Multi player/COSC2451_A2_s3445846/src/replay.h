@@ -0,0 +1,20 @@
+#define REPLAY_VERSION 1
+#define REPLAY_NAME 6  /* 5 letters, as the names of score.sav */
+
+/* what replay_verify() found */
+enum { REPLAY_VALID, REPLAY_ILLEGAL, REPLAY_SCORE, REPLAY_SIZE, REPLAY_FORMAT };
+
+/** @struct Game that can be played again: the board size, the random
+ * numbers of the game (rng_stream(seed, 0, game)), the directions of the
+ * moves and the score the player claims.
+ */
+struct replay {
+	char name[REPLAY_NAME]; int y; unsigned int seed; long game; long long score;
+	long count; unsigned char *moves;  /* MOVE_DOWN to MOVE_RIGHT */
+	bool malformed;  /* the line was not a replay, replay_verify() rejects it */
+};
+
+bool replay_read(FILE *f, struct replay *r);
+void replay_write(FILE *f, const struct replay *r);
+void replay_free(struct replay *r);
+int replay_verify(const struct replay *r, long *move, long long *score);
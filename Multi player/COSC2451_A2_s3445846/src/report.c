@@ -0,0 +1,112 @@
+/** @file report.c
+ * @brief This program merges the summaries of simulation runs written by
+ * train -d or tournament -d and prints them: the quantiles of the score
+ * and of the number of moves, their histograms, the biggest tiles and
+ * the mean tile of every slot at the end of the games.
+ *
+ * Usage: ./report [-o merged] summary...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "rng.h"
+#include "sim.h"
+#include "stats.h"
+
+/** @brief Print a histogram by powers of 2 as bars.
+ * @param name what is counted
+ * @param counts the counts
+ * @param games number of games
+ * @return none
+ */
+static void print_log2(const char *name, const long long *counts, long long games) {
+	printf("\n%s:\n", name);
+	for (int i = 0; i < STATS_LOG2_BINS; ++i) {
+		if (counts[i] == 0) {
+			continue;
+		}
+		long long low = i == 0 ? 0 : 1LL << (i - 1);
+		long long high = i == 0 ? 0 : (1LL << i) - 1;
+		printf("%10lld - %-10lld %6.2f%% ", low, high, 100.0 * counts[i] / games);
+		for (int bar = 0; bar < 50 * counts[i] / games; ++bar) {
+			printf("#");
+		}
+		printf("\n");
+	}
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	const char *output = NULL;
+	static struct stats total, s;
+	int files = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+			output = argv[++i];
+			continue;
+		}
+		if (argv[i][0] == '-' || stats_load(argv[i], &s) == false) {
+			fprintf(stderr, "usage: %s [-o merged] summary...\n%s is not a summary\n", argv[0], argv[i]);
+			return 1;
+		}
+		if (files == 0) {
+			total = s;
+		} else if (stats_merge(&total, &s) == false) {
+			fprintf(stderr, "%s is not a summary of %dx%d boards\n", argv[i], total.y, total.y);
+			return 1;
+		}
+		files++;
+	}
+	if (files == 0 || total.games == 0) {
+		fprintf(stderr, "usage: %s [-o merged] summary...\n", argv[0]);
+		return 1;
+	}
+	if (output != NULL && stats_save(output, &total) == false) {
+		fprintf(stderr, "cannot write %s\n", output);
+		return 1;
+	}
+
+	printf("%lld games of %dx%d from %d summaries\n\n", total.games, total.y, total.y, files);
+	printf("%6s %10s %10s %10s %10s %10s %10s %10s %10s\n", "", "mean", "stddev", "min", "p10", "p50",
+		"p90", "p99", "max");
+	const char *names[2] = {"score", "moves"};
+	for (int w = 0; w < 2; ++w) {
+		double mean = stats_mean(&total, w);
+		double var = total.squares[w] / total.games - mean * mean;
+		printf("%6s %10.1f %10.1f %10lld %10.0f %10.0f %10.0f %10.0f %10lld\n", names[w], mean,
+			sqrt(var > 0 ? var : 0), total.min[w], stats_quantile(&total, w, 0.1),
+			stats_quantile(&total, w, 0.5), stats_quantile(&total, w, 0.9),
+			stats_quantile(&total, w, 0.99), total.max[w]);
+	}
+	print_log2("score", total.log2[STATS_SCORE], total.games);
+	print_log2("moves", total.log2[STATS_MOVES], total.games);
+
+	printf("\nbiggest tile:\n");
+	for (int e = 0; e < STATS_TILES; ++e) {
+		if (total.tiles[e] > 0) {
+			printf("%10d %6.2f%%\n", 1 << e, 100.0 * total.tiles[e] / total.games);
+		}
+	}
+
+	printf("\nmean tile of every slot at the end (2^mean exponent):\n");
+	for (int r = 0; r < total.y; ++r) {
+		for (int c = 0; c < total.y; ++c) {
+			double sum = 0;
+			for (int e = 0; e < STATS_TILES; ++e) {
+				sum += (double) e * total.heat[r * total.y + c][e];
+			}
+			printf("%8.0f", pow(2, sum / total.games));
+		}
+		printf("\n");
+	}
+	return 0;
+}
@@ -0,0 +1,76 @@
+/** @file rng.c
+ * @brief This file contains the counter-based random numbers of the
+ * games (Philox4x32-10): a draw is a hash of the seed of the run, the
+ * game, the move and the use of the draw. A game played on any thread,
+ * or a single move of it, always gets the same numbers, so a run of many
+ * games gives the same results on 1 thread and on 64.
+ */
+
+#include <stdint.h>
+#include "rng.h"
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u  /* added to the key after every round */
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+/** @brief Hash a counter with a key (Philox4x32 with 10 rounds).
+ * @param key the key
+ * @param counter the counter
+ * @param out 4 random numbers
+ * @return none
+ */
+void rng_philox(const uint32_t key[2], const uint32_t counter[4], uint32_t out[4]) {
+	uint32_t k0 = key[0], k1 = key[1];
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+
+	for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+		uint64_t p0 = (uint64_t) PHILOX_M0 * c0;
+		uint64_t p1 = (uint64_t) PHILOX_M1 * c2;
+		uint32_t n0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+		uint32_t n2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+		c1 = (uint32_t) p1;
+		c3 = (uint32_t) p0;
+		c0 = n0;
+		c2 = n2;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+/** @brief Get the random numbers of a game.
+ * @param seed seed of the run
+ * @param round round of the run (generation of the tuner...)
+ * @param game index of the game in the round
+ * @return the stream
+ */
+struct rng_stream rng_stream(unsigned int seed, int round, long game) {
+	struct rng_stream s = {{seed, (uint32_t) round}, (uint64_t) game};
+	return s;
+}
+
+/** @brief Get the random numbers of a move.
+ * @param s the stream of the game
+ * @param move index of the move (of the new number for RNG_SPAWN)
+ * @param use RNG_SPAWN or RNG_AI
+ * @param out 4 random numbers
+ * @return none
+ */
+void rng_draw(const struct rng_stream *s, long move, int use, uint32_t out[4]) {
+	uint32_t counter[4] = {(uint32_t) move, (uint32_t) s->game, (uint32_t) (s->game >> 32), (uint32_t) use};
+	rng_philox(s->key, counter, out);
+}
+
+/** @brief Scale a random number to 0 .. n - 1 (a multiply, not a modulo).
+ * @param r the random number
+ * @param n number of values
+ * @return uint32_t
+ */
+uint32_t rng_below(uint32_t r, uint32_t n) {
+	return (uint32_t) (((uint64_t) r * n) >> 32);
+}
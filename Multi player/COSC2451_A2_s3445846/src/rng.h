@@ -0,0 +1,16 @@
+#include <stdint.h>
+
+/* what a draw of a move is used for, each use gets its own numbers */
+enum { RNG_SPAWN, RNG_AI };
+
+/** @struct Random numbers of one game: every draw is computed from the
+ * key and its position, so it does not depend on the draws before it.
+ */
+struct rng_stream {
+	uint32_t key[2]; uint64_t game;  /* key: seed and round of the run */
+};
+
+void rng_philox(const uint32_t key[2], const uint32_t counter[4], uint32_t out[4]);
+struct rng_stream rng_stream(unsigned int seed, int round, long game);
+void rng_draw(const struct rng_stream *s, long move, int use, uint32_t out[4]);
+uint32_t rng_below(uint32_t r, uint32_t n);
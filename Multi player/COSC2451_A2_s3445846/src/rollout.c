@@ -0,0 +1,286 @@
+/** @file rollout.c
+ * @brief This file contains the Monte Carlo player: every possible move is
+ * scored by the mean score of many random games played after it. The games
+ * are shared by worker threads until the time budget of the move is used,
+ * or sooner when the 95% confidence interval of the best move no longer
+ * overlaps the interval of any other move.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "key_algorithm.h"
+#include "rollout.h"
+
+/** @brief Get the time in seconds.
+ * @return double
+ */
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/** @brief Play random moves until the game is over.
+ * @param m the moves of the board size
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @param seed random seed of the thread
+ * @return the score of the game
+ */
+long long rollout_play(const struct moves *m, unsigned char *a, int y, unsigned int *seed) {
+	void (*dir[4])(unsigned char*, long long*, bool*, bool*, int*) = {m->down, m->up, m->left, m->right};
+	long long score = 0;
+	bool isStuck, isMatch, isFail = false;
+
+	while (true) {
+		int first = rand_r(seed) & 3, i;
+		for (i = 0; i < 4; ++i) {  /* a random direction that moves something */
+			dir[(first + i) & 3](a, &score, &isStuck, &isMatch, &y);
+			if (isStuck == false) {
+				break;
+			}
+		}
+		if (i == 4) {
+			return score;
+		}
+		add_value(a, &isFail, &y, seed);
+	}
+}
+
+/** @brief Play rollouts for every decision until it is stopped.
+ * @param param the pool
+ * @return none
+ */
+static void *worker(void *param) {
+	struct rollout_pool *pool = param;
+	long seen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->seed = pool->seed * 1103515245u + 12345u;
+	unsigned int seed = pool->seed;  /* every thread plays other games */
+
+	while (true) {
+		while (pool->quit == false && (pool->searching == false || pool->job == seen)) {
+			pthread_cond_wait(&pool->work, &pool->lock);
+		}
+		if (pool->quit == true) {
+			break;
+		}
+
+		unsigned char board[64];
+		bool legal[4];
+		int y = pool->y;
+		seen = pool->job;
+		pool->busy++;
+		memcpy(board, pool->board, y * y);
+		memcpy(legal, pool->legal, sizeof(legal));
+		pthread_mutex_unlock(&pool->lock);
+
+		const struct moves *m = get_moves(y);
+		while (atomic_load(&pool->stop) == false) {
+			double sum[4] = {0, 0, 0, 0}, squares[4] = {0, 0, 0, 0};
+			long count[4] = {0, 0, 0, 0};
+
+			for (int d = 0; d < 4; ++d) {
+				for (int b = 0; legal[d] == true && b < ROLLOUT_BATCH; ++b) {
+					if (atomic_load(&pool->stop) == true) {
+						break;
+					}
+					unsigned char clone[64];
+					long long score = 0;
+					bool isFail = false;
+					memcpy(clone, board, y * y);
+					move_table(m, d, clone, &score, &y);
+					add_value(clone, &isFail, &y, &seed);
+					score += rollout_play(m, clone, y, &seed);
+
+					sum[d] += score;
+					squares[d] += (double) score * score;
+					count[d]++;
+				}
+			}
+
+			pthread_mutex_lock(&pool->lock);
+			for (int d = 0; d < 4; ++d) {
+				pool->sum[d] += sum[d];
+				pool->squares[d] += squares[d];
+				pool->count[d] += count[d];
+			}
+			pthread_mutex_unlock(&pool->lock);
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		pool->busy--;
+		pthread_cond_signal(&pool->idle);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+/** @brief Check if the best move is better than every other one
+ * with 95% confidence. The pool is locked.
+ * @param pool the pool
+ * @return bool
+ */
+static bool separated(const struct rollout_pool *pool) {
+	double low[4], high[4];
+	int best = -1;
+
+	for (int d = 0; d < 4; ++d) {
+		if (pool->legal[d] == false) {
+			continue;
+		}
+		long n = pool->count[d];
+		if (n < ROLLOUT_MIN) {
+			return false;
+		}
+		double mean = pool->sum[d] / n;
+		double variance = pool->squares[d] / n - mean * mean;
+		double margin = 1.96 * sqrt(variance > 0 ? variance / n : 0);
+		low[d] = mean - margin;
+		high[d] = mean + margin;
+		if (best < 0 || mean > pool->sum[best] / pool->count[best]) {
+			best = d;
+		}
+	}
+
+	for (int d = 0; d < 4; ++d) {
+		if (pool->legal[d] == true && d != best && high[d] >= low[best]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief Start the worker threads.
+ * @param threads number of threads
+ * @param budget_ms time to decide a move, in milliseconds
+ * @param seed random seed of the rollouts
+ * @return the pool, NULL if there is no memory
+ */
+struct rollout_pool *rollout_start(int threads, int budget_ms, unsigned int seed) {
+	struct rollout_pool *pool = calloc(1, sizeof(struct rollout_pool));
+	if (pool == NULL) {
+		return NULL;
+	}
+	pool->workers = malloc(threads * sizeof(pthread_t));
+	if (pool->workers == NULL) {
+		free(pool);
+		return NULL;
+	}
+
+	pool->threads = threads;
+	pool->budget_ms = budget_ms;
+	pool->seed = seed;
+	atomic_init(&pool->stop, true);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work, NULL);
+	pthread_cond_init(&pool->idle, NULL);
+	for (int i = 0; i < threads; ++i) {
+		pthread_create(&pool->workers[i], NULL, worker, pool);
+	}
+	return pool;
+}
+
+/** @brief Choose the move with the best mean rollout score.
+ * @param pool the pool
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @param report summary of the decision, can be NULL
+ * @return the direction, -1 if nothing can move
+ */
+int rollout_choose(struct rollout_pool *pool, const unsigned char *a, int y, struct rollout_report *report) {
+	const struct moves *m = get_moves(y);
+	double start = now();
+	bool legal[4], early = false;
+	int count = 0, only = -1;
+
+	for (int d = 0; d < 4; ++d) {
+		unsigned char clone[64];
+		long long score = 0;
+		memcpy(clone, a, y * y);
+		legal[d] = move_table(m, d, clone, &score, &y);
+		if (legal[d] == true) {
+			count++;
+			only = d;
+		}
+	}
+	if (report != NULL) {
+		memset(report, 0, sizeof(*report));
+	}
+	if (count <= 1) {  /* nothing to think about */
+		return only;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	memcpy(pool->board, a, y * y);
+	memcpy(pool->legal, legal, sizeof(legal));
+	pool->y = y;
+	memset(pool->sum, 0, sizeof(pool->sum));
+	memset(pool->squares, 0, sizeof(pool->squares));
+	memset(pool->count, 0, sizeof(pool->count));
+	pool->job++;
+	pool->searching = true;
+	atomic_store(&pool->stop, false);
+	pthread_cond_broadcast(&pool->work);
+
+	while ((now() - start) * 1000 < pool->budget_ms) {
+		if (separated(pool) == true) {
+			early = true;
+			break;
+		}
+		pthread_mutex_unlock(&pool->lock);
+		usleep(2000);
+		pthread_mutex_lock(&pool->lock);
+	}
+
+	atomic_store(&pool->stop, true);
+	pool->searching = false;
+	while (pool->busy > 0) {
+		pthread_cond_wait(&pool->idle, &pool->lock);
+	}
+
+	int best = only;  /* kept if the budget was too short for any rollout */
+	double largest = -1;
+	long rollouts = 0;
+	for (int d = 0; d < 4; ++d) {
+		rollouts += pool->count[d];
+		if (pool->count[d] > 0 && pool->sum[d] / pool->count[d] > largest) {
+			largest = pool->sum[d] / pool->count[d];
+			best = d;
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	if (report != NULL) {
+		report->rollouts = rollouts;
+		report->ms = (now() - start) * 1000;
+		report->early = early;
+	}
+	return best;
+}
+
+/** @brief Stop and free the worker threads.
+ * @param pool the pool
+ * @return none
+ */
+void rollout_stop(struct rollout_pool *pool) {
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = true;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (int i = 0; i < pool->threads; ++i) {
+		pthread_join(pool->workers[i], NULL);
+	}
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->work);
+	pthread_cond_destroy(&pool->idle);
+	free(pool->workers);
+	free(pool);
+}
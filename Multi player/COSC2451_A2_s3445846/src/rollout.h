@@ -0,0 +1,28 @@
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define ROLLOUT_MIN 32  /* rollouts of every move before stopping early */
+#define ROLLOUT_BATCH 8  /* rollouts of a thread between 2 merges of its results */
+
+/** @struct Summary of one decision.
+ */
+struct rollout_report {
+	long rollouts; double ms; bool early;  /* early: stopped before the budget was used */
+};
+
+/** @struct Worker threads playing random games from the boards after each move.
+ * The threads wait between 2 decisions, so they are only created once.
+ */
+struct rollout_pool {
+	int threads; int budget_ms; unsigned int seed; pthread_t *workers;
+	pthread_mutex_t lock; pthread_cond_t work; pthread_cond_t idle;
+	unsigned char board[64]; int y; bool legal[4];  /* the decision being made */
+	long job; bool searching; bool quit; int busy; atomic_bool stop;
+	double sum[4]; double squares[4]; long count[4];  /* results of the rollouts */
+};
+
+long long rollout_play(const struct moves *m, unsigned char *a, int y, unsigned int *seed);
+struct rollout_pool *rollout_start(int threads, int budget_ms, unsigned int seed);
+int rollout_choose(struct rollout_pool *pool, const unsigned char *a, int y, struct rollout_report *report);
+void rollout_stop(struct rollout_pool *pool);
@@ -10,33 +10,52 @@
 #include <time.h>
 #include "score.h"
 
-/** @brief Write the current score of player into file
+/** @brief Write the current score of player into the list of unverified scores,
+ * the game keeps no replay so the score cannot go to the score list
  * @param score current score  
  * @return none
  */
-void store_score(int *score) {
-    FILE *f = fopen("score.sav", "a");  /* Open file to write (append mode)*/
-
+void store_score(long long *score) {
     char name[6]; /* The name of user */
     get_name(name); /* Ask player to input name */
 
+    append_score(UNVERIFIED_FILE, name, *score);
+}
+
+/** @brief Write a score into file without asking the name,
+ * SCORE_FILE only takes the scores of replays checked by replay_verify()
+ * @param file the list of scores
+ * @param name the name of player (5 letters)
+ * @param score the score
+ * @return none
+ */
+void append_score(const char *file, const char *name, long long score) {
+    FILE *f = fopen(file, "a");  /* Open file to write (append mode)*/
+    if (!f) {
+        return;
+    }
+
     /* Write player name, score, and playtime*/
-    fprintf(f, "%s %d %d-%d-%d\n", name, *score, get_time(0), get_time(1), get_time(2));      
+    fprintf(f, "%s %lld %d-%d-%d\n", name, score, get_time(0), get_time(1), get_time(2));      
 
     fclose(f); /* Close file */
     
-    sort_score(); /* Soft scores in descending order*/
+    sort_score(file); /* Soft scores in descending order*/
 }
 
 /** @brief Soft scores in descending order
+ * @param file the list of scores
  * @return none
  */
-void sort_score() {
+void sort_score(const char *file) {
         
-    FILE *f = fopen("score.sav", "r"); /* Open file to read data */
+    FILE *f = fopen(file, "r"); /* Open file to read data */
+    if (!f) {
+        return;
+    }
     
     int counter = 0; /* Number of line (scores) in save file */
-    int score[11]; /* Array of scores */
+    long long score[11]; /* Array of scores */
     char data[11][30]; /* Array of string (name, score, date) */ 
 
     /* Get number of line in file */
@@ -54,7 +73,7 @@ void sort_score() {
     for (int i = 0; i < counter; i++) { /* Get the score from file and store in array */
         char name[6];
         char date[10];
-        fscanf(f,"%s %u %s\n", name, &score[i], date); /* Scan the file for score */
+        fscanf(f,"%s %lld %s\n", name, &score[i], date); /* Scan the file for score */
     }
 
     rewind(f); /* Go back to the top of file */
@@ -68,7 +87,7 @@ void sort_score() {
      * Soft array of data depend on the result of scores
      */
     for (int i = 1; i < counter; i++) {
-        int key = score[i]; /* Take the next value in array */
+        long long key = score[i]; /* Take the next value in array */
         int position = i;
 
         char holder[30]; 
@@ -88,7 +107,10 @@ void sort_score() {
 
     fclose(f); /* Close the file */
 
-    f = fopen("score.sav", "w"); /* Open the file to write (overwrite mode) */
+    f = fopen(file, "w"); /* Open the file to write (overwrite mode) */
+    if (!f) {
+        return;
+    }
 
     /* If the number of line is greater than 10 (more than 10 scores)
      * change the counter to 10 (10 scores)
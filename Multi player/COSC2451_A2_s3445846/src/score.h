@@ -1,5 +1,9 @@
-void sort_score();
-void store_score(int *score);
+#define SCORE_FILE "score.sav"  /* the top 10, only scores backed by a valid replay (./verify -a) */
+#define UNVERIFIED_FILE "unverified.sav"  /* the top 10 of the games played here, no replay backs them */
+
+void sort_score(const char *file);
+void store_score(long long *score);
+void append_score(const char *file, const char *name, long long score);
 char get_date();
 int get_time(int choice);
 void get_name(char *array);
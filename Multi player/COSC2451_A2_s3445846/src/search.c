@@ -0,0 +1,303 @@
+/** @file search.c
+ * @brief This file contains the expectimax search of the AI: the AI takes
+ * the move with the best value, and the value of a board after a move is
+ * the mean over every slot where a 2 or a 4 can appear (each half of the
+ * time, as in add_value()). The boards at the end of the search are scored
+ * by the evaluation, and the score made by the moves is added.
+ * With a deadline the search goes 1 move deeper at a time, so a best move
+ * is always ready when the time is up.
+ * A board that is too unlikely to happen (the product of the chances of
+ * its new numbers is below the cutoff) is scored without searching further,
+ * so the many empty slots of an early board do not make the search explode.
+ * The values of the boards after a move are cached, and a board shares its
+ * entry with its rotations and reflections. A cached value is only used by
+ * a search that would not look further: as deep or less, and cut off as
+ * soon or sooner.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <time.h>
+#include "key_algorithm.h"
+#include "eval.h"
+#include "ntuple.h"
+#include "canonical.h"
+#include "search.h"
+
+/** @brief Prepare a search, search_free() frees its cache.
+ * @param s the search
+ * @param y colum length of game board
+ * @param evaluator the evaluation of the board size, NULL (with no network) to count the score of the moves only
+ * @param network the n-tuple network of the board size, NULL to use the evaluation
+ * @return none
+ */
+void search_init(struct search *s, int y, const struct evaluator *evaluator, const struct ntuple *network) {
+	s->y = y;
+	s->moves = get_moves(y);
+	s->evaluator = evaluator;
+	s->network = network;
+	s->nodes = 0;
+	s->cutoff = SEARCH_CUTOFF;
+	s->schedule = true;
+	s->deadline = 0;
+	s->stop = NULL;
+	s->node_limit = 0;
+	s->check = 0;
+	s->timeout = false;
+	s->cache = calloc((size_t) 1 << SEARCH_CACHE_BITS, sizeof(*s->cache));  /* searches without a cache if NULL */
+	s->canonical = true;
+	s->lookups = 0;
+	s->hits = 0;
+}
+
+/** @brief Free the cache of a search.
+ * @param s the search
+ * @return none
+ */
+void search_free(struct search *s) {
+	free(s->cache);
+	s->cache = NULL;
+}
+
+/** @brief Get the current time in seconds.
+ * @return double
+ */
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/** @brief Check if the deadline or the node limit has passed or the search
+ * was stopped, the clock and the stop flag are only read every few nodes.
+ * @param s the search
+ * @return bool
+ */
+static bool expired(struct search *s) {
+	if (s->timeout == false && (s->deadline > 0 || s->stop != NULL || s->node_limit > 0) && s->nodes >= s->check) {
+		s->check = s->nodes + SEARCH_CHECK;
+		s->timeout = (s->stop != NULL && atomic_load_explicit(s->stop, memory_order_relaxed) == true)
+			|| (s->node_limit > 0 && s->nodes >= s->node_limit)
+			|| (s->deadline > 0 && now() > s->deadline);
+	}
+	return s->timeout;
+}
+
+/** @brief Score a board at the end of the search.
+ * @param s the search
+ * @param a the exponents of the game board
+ * @return float
+ */
+static float leaf(struct search *s, const unsigned char *a) {
+	s->nodes++;
+	if (s->network != NULL) {
+		return ntuple_eval(s->network, a);
+	}
+	if (s->evaluator != NULL) {
+		return eval_board(s->evaluator, a);
+	}
+	return 0;
+}
+
+static float best_move(struct search *s, const unsigned char *a, int depth, float probability, int *dir);
+
+/** @brief Get the mean value of a board after a move, over every new number.
+ * @param s the search
+ * @param a the exponents of the game board after the move
+ * @param depth number of moves left to search
+ * @param probability chance of getting to this board from the searched board
+ * @return float
+ */
+static float chance(struct search *s, const unsigned char *a, int depth, float probability) {
+	if (depth == 0 || probability < s->cutoff) {
+		return leaf(s, a);
+	}
+
+	unsigned char board[MAX_LENGTH * MAX_LENGTH];
+	int slots = s->y * s->y, count = 0;
+	float total = 0;
+
+	for (int i = 0; i < slots; ++i) {
+		count += a[i] == 0;
+	}
+	if (count == 0) {
+		return leaf(s, a);
+	}
+
+	/* a value searched at least as deep and cut off no sooner is as good */
+	uint64_t key = 0;
+	float reach = s->cutoff > 0 ? probability / s->cutoff : FLT_MAX;
+	struct search_entry *entry = NULL;
+	if (s->cache != NULL) {
+		key = board_key(a, s->y, s->canonical);
+		entry = &s->cache[(key * 0x9E3779B97F4A7C15ULL) >> (64 - SEARCH_CACHE_BITS)];
+		s->lookups++;
+		if (entry->depth >= depth && entry->reach >= reach && entry->key == key) {
+			s->hits++;
+			return entry->value;
+		}
+	}
+
+	s->nodes++;
+	memcpy(board, a, slots);
+	probability = probability / count * 0.5f;  /* a slot, then a 2 or a 4, half of the time each */
+	for (int i = 0; i < slots && s->timeout == false; ++i) {
+		if (board[i] != 0) {
+			continue;
+		}
+		for (int e = 1; e <= 2; ++e) {
+			int dir;
+			board[i] = e;
+			total += 0.5f * best_move(s, board, depth, probability, &dir);
+		}
+		board[i] = 0;
+	}
+
+	if (entry != NULL && s->timeout == false) {  /* a search stopped by the deadline is not finished */
+		entry->key = key;
+		entry->value = total / count;
+		entry->reach = reach;
+		entry->depth = depth;
+	}
+	return total / count;
+}
+
+/** @brief Get the value of the best move.
+ * @param s the search
+ * @param a the exponents of the game board
+ * @param depth number of moves left to search
+ * @param probability chance of getting to this board from the searched board
+ * @param dir the best direction, -1 if nothing can move
+ * @return the value, SEARCH_LOSS if nothing can move
+ */
+static float best_move(struct search *s, const unsigned char *a, int depth, float probability, int *dir) {
+	float largest = -FLT_MAX;
+	int y = s->y;
+
+	s->nodes++;
+	*dir = -1;
+	for (int d = 0; d < 4 && expired(s) == false; ++d) {
+		unsigned char clone[MAX_LENGTH * MAX_LENGTH];
+		long long score = 0;
+		memcpy(clone, a, y * y);
+
+		if (move_table(s->moves, d, clone, &score, &y) == true) {
+			float value = score + chance(s, clone, depth - 1, probability);
+			if (value > largest) {
+				largest = value;
+				*dir = d;
+			}
+		}
+	}
+	return *dir < 0 ? SEARCH_LOSS : largest;
+}
+
+/** @brief Find the best move. When the stop flag is set during the search,
+ * s->timeout is true afterwards and the direction must not be used.
+ * @param s the search
+ * @param a the exponents of the game board
+ * @param depth number of moves to look ahead (1 only scores the board after each move)
+ * @param value the value of the best move, can be NULL
+ * @return the direction, -1 if nothing can move
+ */
+int search_best(struct search *s, const unsigned char *a, int depth, float *value) {
+	int dir;
+	s->check = s->nodes;
+	s->timeout = false;
+	float best = best_move(s, a, depth, 1, &dir);
+	if (value != NULL) {
+		*value = best;
+	}
+	return dir;
+}
+
+/** @brief Get the depth worth searching on a board. A board with few
+ * different numbers is early in the game and easy to play, a board with
+ * many different numbers and few empty slots needs to look further.
+ * @param s the search
+ * @param a the exponents of the game board
+ * @return int
+ */
+int search_depth(const struct search *s, const unsigned char *a) {
+	bool seen[256] = {false};
+	int slots = s->y * s->y, empty = 0, distinct = 0;
+
+	for (int i = 0; i < slots; ++i) {
+		if (a[i] == 0) {
+			empty++;
+		} else if (seen[a[i]] == false) {
+			seen[a[i]] = true;
+			distinct++;
+		}
+	}
+
+	int depth = distinct - 2;
+	if (empty * 2 >= slots && depth > SEARCH_SPARSE_DEPTH) {
+		depth = SEARCH_SPARSE_DEPTH;
+	} else if (empty < s->y) {  /* less than a row is empty: the end of the game may be near */
+		depth++;
+	}
+	if (depth < 2) {
+		depth = 2;
+	}
+	return depth < SEARCH_MAX_DEPTH ? depth : SEARCH_MAX_DEPTH;
+}
+
+/** @brief Find the best move before a deadline or a number of nodes:
+ * search 1 move ahead, then 2, and so on. The move of the deepest search
+ * finished is taken, a search stopped by the budget is thrown away. With
+ * the schedule on, the search also stops at search_depth() and the rest
+ * of the budget is not used. With a node budget only, the same board
+ * always gets the same move.
+ * @param s the search
+ * @param a the exponents of the game board
+ * @param budget_ms time to think in milliseconds, 0 for no deadline
+ * @param budget_nodes nodes to search, 0 for no limit (1 move ahead is always searched)
+ * @param report the depth reached, the nodes and the time, can be NULL
+ * @return the direction, -1 if nothing can move
+ */
+int search_deadline(struct search *s, const unsigned char *a, int budget_ms, long budget_nodes,
+	struct search_report *report) {
+	double start = now();
+	double stop = budget_ms > 0 ? start + budget_ms * (1 - SEARCH_MARGIN) / 1000.0 : 0;
+	long nodes = s->nodes;
+	long last = budget_nodes > 0 ? nodes + budget_nodes : 0;
+	int best = -1, reached = 0;
+	int limit = s->schedule == true ? search_depth(s, a) : SEARCH_MAX_DEPTH;
+
+	s->deadline = 0;  /* the first depth only scores 4 boards, it always finishes */
+	s->node_limit = 0;
+	s->check = s->nodes;
+	s->timeout = false;
+	for (int depth = 1; depth <= limit; ++depth) {
+		double begin = now();
+		long counted = s->nodes;
+		int dir;
+		best_move(s, a, depth, 1, &dir);
+		if (s->timeout == true) {
+			break;
+		}
+
+		best = dir;
+		reached = depth;
+		double end = now();
+		if (dir < 0 || (stop > 0 && end + (end - begin) * SEARCH_GROWTH > stop)
+			|| (last > 0 && s->nodes + (s->nodes - counted) * SEARCH_GROWTH > last)) {
+			break;
+		}
+		s->deadline = stop;
+		s->node_limit = last;
+	}
+	s->deadline = 0;
+	s->node_limit = 0;
+	s->timeout = false;
+
+	if (report != NULL) {
+		report->depth = reached;
+		report->nodes = s->nodes - nodes;
+		report->ms = (now() - start) * 1000;
+	}
+	return best;
+}
@@ -0,0 +1,48 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define SEARCH_MAX_DEPTH 12  /* deepest iteration of search_deadline() */
+#define SEARCH_CHECK 64  /* nodes searched between 2 looks at the clock */
+#define SEARCH_CUTOFF 0.0001f  /* default chance below which a board is not searched further */
+#define SEARCH_SPARSE_DEPTH 3  /* deepest search of the schedule while half the board is empty */
+#define SEARCH_CACHE_BITS 18  /* the cache keeps the values of 2^18 boards */
+#define SEARCH_LOSS -1e9f  /* value of a lost board, below any evaluation */
+#define SEARCH_MARGIN 0.05  /* part of the time kept to stop the search and make the move */
+#define SEARCH_GROWTH 4  /* a depth is not started when it would take longer than the time left */
+
+/** @struct Value of a board after a move, searched depth moves ahead (0: empty entry).
+ * reach is the chance of the board divided by the cutoff: the higher it is,
+ * the later the search was cut off.
+ */
+struct search_entry {
+	uint64_t key; float value; float reach; int depth;
+};
+
+/** @struct Expectimax search of one board size. Boards are scored by the
+ * n-tuple network when there is one, else by the evaluation; without
+ * both only the score made by the moves counts.
+ */
+struct search {
+	int y; const struct moves *moves;
+	const struct evaluator *evaluator; const struct ntuple *network;
+	long nodes;  /* boards scored or expanded since the last search_init() */
+	float cutoff; bool schedule;  /* schedule: search_deadline() stops at search_depth() */
+	struct search_entry *cache; bool canonical; long lookups; long hits;  /* canonical: key the symmetries together */
+	double deadline; long check; bool timeout;  /* deadline: clock time to stop at, 0 for none */
+	long node_limit;  /* value of nodes to stop at, 0 for none */
+	const atomic_bool *stop;  /* set by another thread to stop the search, can be NULL */
+};
+
+/** @struct Summary of one move of search_deadline().
+ */
+struct search_report {
+	int depth; long nodes; double ms;  /* depth: deepest search finished */
+};
+
+void search_init(struct search *s, int y, const struct evaluator *evaluator, const struct ntuple *network);
+void search_free(struct search *s);
+int search_best(struct search *s, const unsigned char *a, int depth, float *value);
+int search_depth(const struct search *s, const unsigned char *a);
+int search_deadline(struct search *s, const unsigned char *a, int budget_ms, long budget_nodes,
+	struct search_report *report);
@@ -0,0 +1,404 @@
+/** @file server.c
+ * @brief This program hosts many games in one process: clients connect
+ * to a local socket and play through requests (server.h) that call the
+ * functions of the game (the moves, add_value_at() and check_failing()).
+ * One thread waits on every connection with epoll and answers the
+ * requests in the order they came, a client can send many of them
+ * without waiting for the answers. The games and the connections are
+ * kept in slabs (slab.c), a connection may open many games.
+ * The new numbers of a game come from rng_stream(seed, 0, game), so a
+ * game of the server can be checked again with ./verify.
+ *
+ * Usage: ./server [-p socket] [-m sessions]
+ * (default: -p 2048.sock -m 1000000)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "key_algorithm.h"
+#include "rng.h"
+#include "slab.h"
+#include "server.h"
+
+#define SERVER_EVENTS 256  /* events handled per call of epoll_wait() */
+#define SERVER_BUFFER 16384  /* bytes of the buffers of a connection */
+#define SERVER_CONNECTIONS 65536
+
+/** @struct Game of a client, in the list of the games of its connection.
+ */
+struct session {
+	uint32_t owner; uint32_t prev; uint32_t next;  /* owner: the connection */
+	int y; bool isFail; long long score;
+	struct rng_stream stream; long spawns;  /* spawns: new numbers added */
+	unsigned char board[MAX_LENGTH * MAX_LENGTH];
+};
+
+/** @struct Client connection: the requests read and not answered yet,
+ * then the answers not written yet.
+ */
+struct connection {
+	int fd; uint32_t id; uint32_t sessions;  /* sessions: the first game */
+	size_t in; size_t start; size_t out;  /* in: bytes read, start..out: bytes to write */
+	bool writing;  /* waits for the socket to take the answers */
+	unsigned char input[SERVER_BUFFER]; unsigned char output[SERVER_BUFFER];
+};
+
+/** @struct State of the server.
+ */
+struct server {
+	int epoll; int listener;
+	struct slab sessions; struct slab connections;
+	long requests;
+};
+
+static volatile sig_atomic_t stopping = 0;
+
+/** @brief Stop the server after the current events.
+ * @param signal the signal
+ * @return none
+ */
+static void stop(int signal) {
+	(void) signal;
+	stopping = 1;
+}
+
+/** @brief Open a game and add it to the games of the connection.
+ * @param sv the server
+ * @param c the connection
+ * @param y colum length of game board
+ * @param seed seed of the random numbers
+ * @param game game of the seed
+ * @param id the session
+ * @return SERVER_OK, SERVER_INVALID or SERVER_BUSY
+ */
+static int open_session(struct server *sv, struct connection *c, int y, unsigned int seed, long game, uint32_t *id) {
+	if (y < 3 || y > MAX_LENGTH) {
+		return SERVER_INVALID;
+	}
+	struct session *s = slab_alloc(&sv->sessions, id);
+	if (s == NULL) {
+		return SERVER_BUSY;
+	}
+	s->owner = c->id;
+	s->prev = SLAB_NONE;
+	s->next = c->sessions;
+	if (c->sessions != SLAB_NONE) {
+		((struct session *) slab_get(&sv->sessions, c->sessions))->prev = *id;
+	}
+	c->sessions = *id;
+
+	s->y = y;
+	s->stream = rng_stream(seed, 0, game);
+	add_value_at(s->board, &s->isFail, &s->y, &s->stream, s->spawns++);  /* as init_table() */
+	add_value_at(s->board, &s->isFail, &s->y, &s->stream, s->spawns++);
+	return SERVER_OK;
+}
+
+/** @brief Close a game and take it out of the games of its connection.
+ * @param sv the server
+ * @param c the connection
+ * @param id the session
+ * @return none
+ */
+static void close_session(struct server *sv, struct connection *c, uint32_t id) {
+	struct session *s = slab_get(&sv->sessions, id);
+	if (s->prev != SLAB_NONE) {
+		((struct session *) slab_get(&sv->sessions, s->prev))->next = s->next;
+	} else {
+		c->sessions = s->next;
+	}
+	if (s->next != SLAB_NONE) {
+		((struct session *) slab_get(&sv->sessions, s->next))->prev = s->prev;
+	}
+	slab_free(&sv->sessions, id);
+}
+
+/** @brief Answer one request, the answer is added to the output of the connection.
+ * @param sv the server
+ * @param c the connection, its output has room for an answer and SERVER_PAYLOAD bytes
+ * @param q the request
+ * @return none
+ */
+static void answer(struct server *sv, struct connection *c, const struct server_request *q) {
+	struct server_reply r;
+	memset(&r, 0, sizeof(r));
+	r.op = q->op;
+	r.tag = q->tag;
+	sv->requests++;
+
+	struct session *s = NULL;
+	if (q->op != SERVER_OPEN) {
+		s = slab_get(&sv->sessions, q->session);
+		if (s == NULL || s->owner != c->id) {  /* the games of the other clients are not there */
+			s = NULL;
+			r.status = SERVER_UNKNOWN;
+		}
+	}
+
+	size_t payload = 0;
+	if (q->op == SERVER_OPEN) {
+		uint32_t id = SLAB_NONE;
+		r.status = open_session(sv, c, q->arg, q->value, q->session, &id);
+		r.value = id;
+	} else if (s == NULL) {
+		/* the status is set */
+	} else if (q->op == SERVER_MOVE && q->arg <= MOVE_RIGHT) {
+		long long before = s->score;
+		r.a = move_table(get_moves(s->y), q->arg, s->board, &s->score, &s->y);
+		r.value = s->score - before;
+	} else if (q->op == SERVER_ADD) {
+		unsigned char before[MAX_LENGTH * MAX_LENGTH];
+		memcpy(before, s->board, s->y * s->y);
+		add_value_at(s->board, &s->isFail, &s->y, &s->stream, s->spawns);
+		for (int i = 0; i < s->y * s->y; ++i) {
+			if (s->board[i] != before[i]) {
+				r.a = i;
+				r.b = s->board[i];
+				s->spawns++;
+			}
+		}
+	} else if (q->op == SERVER_CHECK) {
+		check_failing(s->board, &s->isFail, &s->y);
+		r.a = s->isFail;
+	} else if (q->op == SERVER_BOARD) {
+		int64_t score = s->score;
+		payload = s->y * s->y + sizeof(score);
+		r.value = payload;
+		memcpy(c->output + c->out + sizeof(r), s->board, s->y * s->y);
+		memcpy(c->output + c->out + sizeof(r) + s->y * s->y, &score, sizeof(score));
+	} else if (q->op == SERVER_CLOSE) {
+		close_session(sv, c, q->session);
+	} else {
+		r.status = SERVER_INVALID;
+	}
+	memcpy(c->output + c->out, &r, sizeof(r));
+	c->out += sizeof(r) + payload;
+}
+
+/** @brief Close a connection and every game it opened.
+ * @param sv the server
+ * @param c the connection
+ * @return none
+ */
+static void drop(struct server *sv, struct connection *c) {
+	while (c->sessions != SLAB_NONE) {
+		close_session(sv, c, c->sessions);
+	}
+	epoll_ctl(sv->epoll, EPOLL_CTL_DEL, c->fd, NULL);
+	close(c->fd);
+	slab_free(&sv->connections, c->id);
+}
+
+/** @brief Write the answers waiting, the connection waits for the socket
+ * when it does not take them all.
+ * @param sv the server
+ * @param c the connection
+ * @return false if the connection is closed
+ */
+static bool flush(struct server *sv, struct connection *c) {
+	while (c->start < c->out) {
+		ssize_t n = write(c->fd, c->output + c->start, c->out - c->start);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		}
+		if (n <= 0) {
+			drop(sv, c);
+			return false;
+		}
+		c->start += n;
+	}
+	if (c->start == c->out) {
+		c->start = 0;
+		c->out = 0;
+	}
+
+	bool writing = c->out > 0;
+	if (writing != c->writing) {  /* stop reading until the answers are taken */
+		struct epoll_event e;
+		e.events = writing ? EPOLLOUT : EPOLLIN;
+		e.data.ptr = c;
+		epoll_ctl(sv->epoll, EPOLL_CTL_MOD, c->fd, &e);
+		c->writing = writing;
+	}
+	return true;
+}
+
+/** @brief Answer every whole request read: the answers are written each
+ * time the output is full, until no whole request is left or the socket
+ * does not take more (the rest is answered once it is written).
+ * @param sv the server
+ * @param c the connection
+ * @return false if the connection is closed
+ */
+static bool serve(struct server *sv, struct connection *c) {
+	while (true) {
+		size_t done = 0;
+		while (c->in - done >= sizeof(struct server_request)
+			&& c->out + sizeof(struct server_reply) + SERVER_PAYLOAD <= SERVER_BUFFER) {
+			struct server_request q;
+			memcpy(&q, c->input + done, sizeof(q));
+			answer(sv, c, &q);
+			done += sizeof(q);
+		}
+		memmove(c->input, c->input + done, c->in - done);  /* the rest of a request, or the requests not answered */
+		c->in -= done;
+		if (flush(sv, c) == false) {
+			return false;
+		}
+		if (c->writing == true || c->in < sizeof(struct server_request)) {
+			return true;
+		}
+	}
+}
+
+/** @brief Read the requests of a connection and answer them.
+ * @param sv the server
+ * @param c the connection
+ * @return none
+ */
+static void readable(struct server *sv, struct connection *c) {
+	ssize_t n = read(c->fd, c->input + c->in, SERVER_BUFFER - c->in);
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+		return;
+	}
+	if (n <= 0) {
+		drop(sv, c);
+		return;
+	}
+	c->in += n;
+	serve(sv, c);
+}
+
+/** @brief Accept the new connections.
+ * @param sv the server
+ * @return none
+ */
+static void accept_all(struct server *sv) {
+	while (true) {
+		int fd = accept4(sv->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				perror("accept");
+			}
+			return;
+		}
+
+		uint32_t id;
+		struct connection *c = slab_alloc(&sv->connections, &id);
+		if (c == NULL) {
+			close(fd);
+			continue;
+		}
+		c->fd = fd;
+		c->id = id;
+		c->sessions = SLAB_NONE;
+		struct epoll_event e;
+		e.events = EPOLLIN;
+		e.data.ptr = c;
+		if (epoll_ctl(sv->epoll, EPOLL_CTL_ADD, fd, &e) < 0) {
+			close(fd);
+			slab_free(&sv->connections, id);
+		}
+	}
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	const char *path = SERVER_SOCKET;
+	long limit = 1000000;
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "-p") == 0) {
+			path = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+			limit = atol(argv[++i]);
+		} else {
+			fprintf(stderr, "usage: %s [-p socket] [-m sessions]\n", argv[0]);
+			return 1;
+		}
+	}
+	struct sockaddr_un address;
+	if (limit < 1 || limit >= SLAB_NONE - 1 || strlen(path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	struct server sv;
+	memset(&sv, 0, sizeof(sv));
+	slab_init(&sv.sessions, sizeof(struct session), limit);
+	slab_init(&sv.connections, sizeof(struct connection), SERVER_CONNECTIONS);
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+	unlink(path);
+	sv.listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (sv.listener < 0 || bind(sv.listener, (struct sockaddr *) &address, sizeof(address)) < 0
+		|| listen(sv.listener, SOMAXCONN) < 0) {
+		perror(path);
+		return 1;
+	}
+	sv.epoll = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event e;
+	e.events = EPOLLIN;
+	e.data.ptr = NULL;  /* the listener */
+	epoll_ctl(sv.epoll, EPOLL_CTL_ADD, sv.listener, &e);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stop;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);  /* a client gone is seen by write() */
+	printf("listening on %s\n", path);
+	fflush(stdout);
+
+	struct epoll_event events[SERVER_EVENTS];
+	while (stopping == 0) {
+		int n = epoll_wait(sv.epoll, events, SERVER_EVENTS, -1);
+		for (int i = 0; i < n; ++i) {
+			struct connection *c = events[i].data.ptr;
+			if (c == NULL) {
+				accept_all(&sv);
+			} else if (events[i].events & EPOLLOUT) {
+				if (flush(&sv, c) == true && c->writing == false) {
+					serve(&sv, c);  /* the requests left while the answers were waiting */
+				}
+			} else {
+				readable(&sv, c);
+			}
+		}
+	}
+
+	printf("%ld requests, %u sessions open, %u connections\n", sv.requests, sv.sessions.used, sv.connections.used);
+	for (uint32_t id = 0; id < sv.connections.count; ++id) {
+		struct connection *c = slab_get(&sv.connections, id);
+		if (c != NULL) {
+			drop(&sv, c);
+		}
+	}
+	slab_destroy(&sv.sessions);
+	slab_destroy(&sv.connections);
+	close(sv.epoll);
+	close(sv.listener);
+	unlink(path);
+	return 0;
+}
@@ -0,0 +1,31 @@
+#include <stdint.h>
+
+#define SERVER_SOCKET "2048.sock"  /* default path of the socket */
+#define SERVER_PAYLOAD (64 + 8)  /* most bytes after an answer: the board, then the score */
+
+/* requests, the moves are MOVE_DOWN to MOVE_RIGHT in the argument of SERVER_MOVE */
+enum { SERVER_OPEN, SERVER_MOVE, SERVER_ADD, SERVER_CHECK, SERVER_BOARD, SERVER_CLOSE };
+
+/* status of an answer */
+enum { SERVER_OK, SERVER_UNKNOWN, SERVER_INVALID, SERVER_BUSY };
+
+/** @struct Request of a client, in the byte order of the machine. The
+ * client may send many requests without waiting, they are answered in order.
+ * SERVER_OPEN: arg is the board size, value the seed and session the game of the seed.
+ */
+struct server_request {
+	uint8_t op; uint8_t arg; uint16_t tag;  /* tag: copied to the answer */
+	uint32_t session; uint32_t value;
+};
+
+/** @struct Answer of the server.
+ * SERVER_OPEN: value is the session.
+ * SERVER_MOVE: a is 1 if the board moved, value the score made by the move.
+ * SERVER_ADD: a is the slot of the new number and b its exponent, b is 0 on a full board.
+ * SERVER_CHECK: a is 1 if no move is left (check_failing()).
+ * SERVER_BOARD: value bytes follow, the exponents of the board then the score (int64_t).
+ */
+struct server_reply {
+	uint8_t op; uint8_t status; uint16_t tag;
+	uint8_t a; uint8_t b; uint16_t unused; uint32_t value;
+};
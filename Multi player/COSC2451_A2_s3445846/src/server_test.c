@@ -0,0 +1,221 @@
+/** @file server_test.c
+ * @brief This program checks the server. Pipelined requests: it starts
+ * ./server, opens a game and sends in one write more requests than the
+ * buffers of a connection hold, then every answer must come back in order.
+ * The limit of games: with -m it opens more games than the limit in one
+ * write, and only the limit must be opened, the others are busy.
+ *
+ * Usage: ./server_test [requests]
+ * (default: 2000 board requests, about 4 times the output of a connection)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "server.h"
+
+#define TEST_SOCKET "server_test.sock"
+#define TEST_TIMEOUT 5000  /* ms without an answer before the test fails */
+#define TEST_LIMIT 10  /* -m of the server in the test of the limit */
+#define TEST_OPENS 50  /* games opened in the test of the limit */
+
+/** @brief Start the server on the socket of the test and connect to it.
+ * @param pid the server process
+ * @param limit most games of the server (its -m)
+ * @return the connection, -1 if the server does not start
+ */
+static int start(pid_t *pid, long limit) {
+	char games[32];
+	snprintf(games, sizeof(games), "%ld", limit);
+	fflush(stdout);  /* the child would print it again */
+	*pid = fork();
+	if (*pid == 0) {
+		freopen("/dev/null", "w", stdout);
+		execl("./server", "./server", "-p", TEST_SOCKET, "-m", games, (char *) NULL);
+		_exit(127);
+	}
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, TEST_SOCKET);
+	for (int tries = 0; tries < 100; ++tries) {  /* the server needs a moment to listen */
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (connect(fd, (struct sockaddr *) &address, sizeof(address)) == 0) {
+			return fd;
+		}
+		close(fd);
+		usleep(20000);
+	}
+	return -1;
+}
+
+/** @brief Stop the server.
+ * @param pid the server process
+ * @param fd the connection
+ * @return none
+ */
+static void stop(pid_t pid, int fd) {
+	close(fd);
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+}
+
+/** @brief Send many board requests of a game in one write and read every answer.
+ * @param count number of board requests
+ * @return false if an answer is missing or wrong
+ */
+static bool pipelined(long count) {
+	pid_t pid;
+	int fd = start(&pid, 1000);
+	if (fd < 0) {
+		fprintf(stderr, "the server does not start\n");
+		return false;
+	}
+
+	/* the game, then its board again and again, in one write */
+	size_t size = sizeof(struct server_request);
+	struct server_request *q = calloc(count + 1, sizeof(struct server_request));
+	unsigned char *input = malloc((count + 1) * (sizeof(struct server_reply) + SERVER_PAYLOAD));
+	q[0].op = SERVER_OPEN;
+	q[0].arg = 4;
+	q[0].value = 1;
+	for (long i = 1; i <= count; ++i) {
+		q[i].op = SERVER_BOARD;
+		q[i].tag = i;
+	}
+
+	size_t sent = 0, got = 0, parsed = 0;
+	long answers = 0;
+	bool ok = true;
+	unsigned char board[SERVER_PAYLOAD];
+	while (answers <= count && ok == true) {
+		struct pollfd p = {fd, POLLIN | (sent < size ? POLLOUT : 0), 0};
+		if (poll(&p, 1, TEST_TIMEOUT) <= 0) {
+			fprintf(stderr, "no answer after %ld of %ld\n", answers, count + 1);
+			ok = false;
+			break;
+		}
+		if (p.revents & POLLOUT) {
+			ssize_t n = send(fd, (char *) q + sent, size - sent, MSG_DONTWAIT);
+			sent += n > 0 ? n : 0;
+		}
+		if (p.revents & POLLIN) {
+			ssize_t n = recv(fd, input + got, (count + 1) * (sizeof(struct server_reply) + SERVER_PAYLOAD) - got,
+				MSG_DONTWAIT);
+			if (n <= 0 && errno != EAGAIN) {
+				fprintf(stderr, "the server closed the connection\n");
+				ok = false;
+				break;
+			}
+			got += n > 0 ? n : 0;
+		}
+
+		/* every answer in order, every board the same */
+		while (got - parsed >= sizeof(struct server_reply) && ok == true) {
+			struct server_reply r;
+			memcpy(&r, input + parsed, sizeof(r));
+			size_t payload = r.op == SERVER_BOARD ? r.value : 0;
+			if (got - parsed < sizeof(r) + payload) {
+				break;
+			}
+			if (r.status != SERVER_OK || r.tag != answers || r.op != q[answers].op || payload > SERVER_PAYLOAD) {
+				fprintf(stderr, "answer %ld is wrong\n", answers);
+				ok = false;
+			} else if (answers == 0) {
+				for (long i = 1; i <= count; ++i) {
+					q[i].session = r.value;
+				}
+				size = (count + 1) * sizeof(struct server_request);
+			} else if (answers == 1) {
+				memcpy(board, input + parsed + sizeof(r), payload);
+			} else if (memcmp(board, input + parsed + sizeof(r), payload) != 0) {
+				fprintf(stderr, "board %ld is not the same\n", answers);
+				ok = false;
+			}
+			parsed += sizeof(r) + payload;
+			answers++;
+		}
+	}
+
+	stop(pid, fd);
+	free(q);
+	free(input);
+	if (ok == true) {
+		printf("ok: %ld pipelined answers\n", answers);
+	}
+	return ok;
+}
+
+/** @brief Open more games than the limit of the server in one write.
+ * @return false if the server does not open exactly its limit
+ */
+static bool limited() {
+	pid_t pid;
+	int fd = start(&pid, TEST_LIMIT);
+	if (fd < 0) {
+		fprintf(stderr, "the server does not start\n");
+		return false;
+	}
+
+	struct server_request q[TEST_OPENS];
+	memset(q, 0, sizeof(q));
+	for (int i = 0; i < TEST_OPENS; ++i) {
+		q[i].op = SERVER_OPEN;
+		q[i].arg = 4;
+		q[i].tag = i;
+		q[i].value = 1;
+		q[i].session = i;
+	}
+	bool ok = write(fd, q, sizeof(q)) == sizeof(q);
+
+	/* the answers of an open have nothing after them */
+	unsigned char input[TEST_OPENS * sizeof(struct server_reply)];
+	size_t got = 0;
+	while (ok == true && got < sizeof(input)) {
+		struct pollfd p = {fd, POLLIN, 0};
+		ssize_t n = poll(&p, 1, TEST_TIMEOUT) > 0 ? read(fd, input + got, sizeof(input) - got) : 0;
+		ok = n > 0;
+		got += n > 0 ? n : 0;
+	}
+	int opened = 0, busy = 0;
+	for (int i = 0; i < TEST_OPENS && ok == true; ++i) {
+		struct server_reply r;
+		memcpy(&r, input + i * sizeof(r), sizeof(r));
+		opened += r.status == SERVER_OK;
+		busy += r.status == SERVER_BUSY;
+	}
+	stop(pid, fd);
+	if (ok == false || opened != TEST_LIMIT || busy != TEST_OPENS - TEST_LIMIT) {
+		fprintf(stderr, "-m %d: %d of %d games opened, %d busy\n", TEST_LIMIT, opened, TEST_OPENS, busy);
+		return false;
+	}
+	printf("ok: %d of %d games opened with -m %d\n", opened, TEST_OPENS, TEST_LIMIT);
+	return true;
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return 0 if every check passes
+ */
+int main(int argc, char *argv[]) {
+	long count = argc > 1 ? atol(argv[1]) : 2000;
+	if (count < 1 || count > 65535) {
+		fprintf(stderr, "usage: %s [requests]\n", argv[0]);
+		return 1;
+	}
+	bool ok = pipelined(count);
+	ok = limited() && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/** @file session.c
+ * @brief This file maps the game session into memory, so the boards,
+ * scores, random seeds and timer survive a quit or a crash.
+ * Every running game holds an exclusive lock on its file, so 2 games
+ * never share one, and a new game does not take the file of a game
+ * that can still be resumed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include "session.h"
+#include "ai.h"
+
+static int session_lock = -1;  /* the file of the session, open while the game runs to keep its lock */
+
+/** @brief Check if a session holds a game that can be resumed. The file
+ * may be stale or damaged, so every value used as an index is checked:
+ * the size, the AI level, the thinking time and the tiles (2^31 at most).
+ * @param session the session
+ * @return bool
+ */
+static bool unfinished(const struct session *session) {
+	const struct player *p = &session->p;
+	int y = p->y;
+	bool valid = memcmp(session->magic, "2048", 4) == 0 && session->version == SESSION_VERSION
+		&& y >= 3 && y * y <= MAX_SLOTS && p->isFail1 == false && p->isFail2 == false
+		&& p->level >= 0 && p->level < AI_LEVELS && p->deadline > 0;
+	for (int i = 0; i < y * y && valid == true; ++i) {
+		valid = session->table1[i] <= 31 && session->table2[i] <= 31;
+	}
+	return valid;
+}
+
+/** @brief Open a session file and lock it.
+ * @param path the session file
+ * @param create true to create a missing file
+ * @return the file descriptor, -1 if it cannot be opened or another game uses it
+ */
+static int lock_file(const char *path, bool create) {
+	int fd = open(path, create ? O_RDWR | O_CREAT : O_RDWR, 0644);
+	if (fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/** @brief Map the session file into memory. A new session is cleared,
+ * a resumed one is checked and its board pointers are fixed up.
+ * If the file cannot be used, a new session falls back to anonymous memory.
+ * @param path the session file, NULL for a new session without a file
+ * @param resume true to restore the previous session
+ * @return the mapped session, NULL if there is no session to resume or another game uses it
+ */
+struct session *session_open(const char *path, bool resume) {
+	struct session *session = MAP_FAILED;
+	int fd = path != NULL ? lock_file(path, resume == false) : -1;
+
+	if (fd >= 0) {
+		/* a resumed file must already hold a whole session */
+		if (resume == false || lseek(fd, 0, SEEK_END) == sizeof(struct session)) {
+			if (ftruncate(fd, sizeof(struct session)) == 0) {
+				session = mmap(NULL, sizeof(struct session), PROT_READ | PROT_WRITE,
+					MAP_SHARED, fd, 0);
+			}
+		}
+		if (session != MAP_FAILED) {
+			session_lock = fd;  /* the mapping stays valid, the file stays open for its lock */
+		} else {
+			close(fd);
+		}
+	}
+
+	if (resume == true) {
+		if (session == MAP_FAILED) {
+			return NULL;
+		}
+
+		/* reject files written by another version, a broken or a finished game */
+		if (unfinished(session) == false) {
+			session_close(session);
+			return NULL;
+		}
+		session->p.resumed = true;
+		session->p.quit = false;
+		session->p.inp = session->mode;
+	} else {
+		if (session == MAP_FAILED) {  /* play without saving */
+			session = mmap(NULL, sizeof(struct session), PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+			if (session == MAP_FAILED) {
+				return NULL;
+			}
+		}
+		memset(session, 0, sizeof(struct session));
+		memcpy(session->magic, "2048", 4);
+		session->version = SESSION_VERSION;
+	}
+
+	/* the pointers were saved by another process, point them to this mapping */
+	session->p.table1 = session->table1;
+	session->p.table2 = session->table2;
+	return session;
+}
+
+/** @brief Start a new session in the first session file that no game
+ * uses and that holds no game to resume: session.sav, then session2.sav
+ * and so on. When every file is taken, the game is played without saving.
+ * @param path the name of the file taken, empty without a file
+ * @param size bytes of path
+ * @return the mapped session, NULL if there is no memory
+ */
+struct session *session_start(char *path, size_t size) {
+	for (int i = 1; i <= SESSION_FILES; ++i) {
+		char name[32];
+		struct session old;
+		if (i == 1) {
+			snprintf(name, sizeof(name), "%s", SESSION_FILE);
+		} else {
+			snprintf(name, sizeof(name), "session%d.sav", i);
+		}
+
+		int fd = lock_file(name, true);
+		if (fd < 0) {
+			continue;  /* another game is running on it */
+		}
+		bool taken = pread(fd, &old, sizeof(old), 0) == sizeof(old) && unfinished(&old);
+		close(fd);  /* session_open() locks it again */
+		if (taken == false) {
+			struct session *session = session_open(name, false);
+			if (session != NULL && session_lock >= 0) {
+				snprintf(path, size, "%s", name);
+				return session;
+			}
+			if (session != NULL) {
+				session_close(session);
+			}
+		}
+	}
+	snprintf(path, size, "%s", "");
+	return session_open(NULL, false);
+}
+
+/** @brief Unmap the session, the kernel writes the pages back to the file,
+ * and let another game use the file.
+ * @param session the mapped session
+ * @return none
+ */
+void session_close(struct session *session) {
+	munmap(session, sizeof(struct session));
+	if (session_lock >= 0) {
+		close(session_lock);
+		session_lock = -1;
+	}
+}
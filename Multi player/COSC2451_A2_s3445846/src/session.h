@@ -0,0 +1,35 @@
+#include <stdbool.h>
+
+#define SESSION_FILE "session.sav"  /* the first session file, the next ones are session2.sav ... */
+#define SESSION_FILES 9
+#define SESSION_VERSION 7
+#define MAX_SLOTS 64  /* number of slots of the biggest board (8 x 8) */
+
+/* AI playing the left table in AI vs AI mode */
+enum { AI_MEDIUM, AI_MCTS };
+
+#define AI_DEADLINE 1000  /* default thinking time of the AI per move in timed mode, in ms */
+
+/** @struct Structure containing the properties of 2 players.
+ * The tables store the exponent of 2 of each number.
+ */
+struct player {
+	unsigned char *table1; unsigned char *table2; int y;  int inp;  long long score1; long long score2; int timer;
+	bool isStuck1; bool isMatch1; bool isFail1; bool isFail2; bool isStuck2; bool isMatch2;
+	unsigned int seed1; unsigned int seed2; int time_limit; bool resumed; bool quit; int ai1;
+	int deadline; float cutoff;  /* ms the AI thinks per move in the timed Human vs AI modes, its search cutoff */
+	int level;  /* index of the AI level in Human vs AI mode */
+};
+
+/** @struct Fixed-size game session, mapped from the session file
+ * so every move is persisted in place.
+ */
+struct session {
+	char magic[4]; int version; int mode;
+	struct player p;
+	unsigned char table1[MAX_SLOTS]; unsigned char table2[MAX_SLOTS];
+};
+
+struct session *session_open(const char *path, bool resume);
+struct session *session_start(char *path, size_t size);
+void session_close(struct session *session);
@@ -0,0 +1,357 @@
+/** @file shard.c
+ * @brief This program splits a long simulation run between worker
+ * processes: each one plays a range of the games with an AI level and
+ * sends the summary of its games (stats.c) to the coordinator through a
+ * pipe every few games. A worker that crashes is started again from the
+ * last games it sent, and as every game has its own random numbers
+ * (rng.c) the run gives the same summary whatever happens to the workers.
+ * Every worker is pinned to a CPU, or to the CPUs of a NUMA node with -n,
+ * before it allocates its memory so the memory is on its node.
+ *
+ * Usage: ./shard [-w workers] [-g games] [-y size] [-s seed] [-l level]
+ *                [-c games] [-n] [-d summary]
+ * (default: one worker per CPU, -g 10000 -y 4 -s 1 -l 3 -c 100,
+ * -c is the number of games between 2 checkpoints of a worker,
+ * -d writes the summary of the run for ./report)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sched.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "key_algorithm.h"
+#include "search.h"
+#include "rng.h"
+#include "sim.h"
+#include "stats.h"
+#include "ai.h"
+
+#define SHARD_MAX_WORKERS 256
+#define SHARD_RESTARTS 3  /* crashes of a worker at the same checkpoint before giving up */
+#define SHARD_MAX_NODES 64
+
+/** @struct Message of a worker: the summary of its games since the last message.
+ */
+struct checkpoint {
+	long next;  /* first game the worker has not played yet */
+	struct stats stats;
+};
+
+/** @struct Worker process and the games it has sent.
+ */
+struct shard {
+	pid_t pid; int fd;  /* the read end of its pipe, -1 when it is not running */
+	long next; long end;  /* games next .. end - 1 are left */
+	int restarts; struct stats stats;
+};
+
+/** @brief Read the CPUs of every NUMA node from /sys.
+ * @param nodes the CPUs of every node
+ * @return number of nodes, 0 if they are not known
+ */
+static int read_nodes(cpu_set_t *nodes) {
+	int count = 0;
+	for (int n = 0; n < SHARD_MAX_NODES; ++n) {
+		char path[64];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+		FILE *f = fopen(path, "r");
+		if (!f) {
+			continue;
+		}
+		CPU_ZERO(&nodes[count]);
+		int low, high;
+		while (fscanf(f, "%d", &low) == 1) {  /* "0-3,8-11" */
+			high = low;
+			if (fscanf(f, "-%d", &high) != 1) {
+				high = low;
+			}
+			for (int cpu = low; cpu <= high && cpu < CPU_SETSIZE; ++cpu) {
+				CPU_SET(cpu, &nodes[count]);
+			}
+			if (fgetc(f) != ',') {
+				break;
+			}
+		}
+		fclose(f);
+		count += CPU_COUNT(&nodes[count]) > 0;
+	}
+	return count;
+}
+
+/** @brief Write a whole buffer to a pipe.
+ * @param fd the pipe
+ * @param data the buffer
+ * @param size size of the buffer
+ * @return false if the pipe is closed
+ */
+static bool write_all(int fd, const void *data, size_t size) {
+	const char *p = data;
+	while (size > 0) {
+		ssize_t n = write(fd, p, size);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+/** @brief Read a whole buffer from a pipe.
+ * @param fd the pipe
+ * @param data the buffer
+ * @param size size of the buffer
+ * @return false if the pipe is closed before the end
+ */
+static bool read_all(int fd, void *data, size_t size) {
+	char *p = data;
+	while (size > 0) {
+		ssize_t n = read(fd, p, size);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+/** @brief Play games start .. end - 1 in a worker process and send a
+ * checkpoint every few games and at the end.
+ * @param fd the write end of the pipe
+ * @param y colum length of game board
+ * @param seed seed of the run
+ * @param level index of the AI level in ai_levels
+ * @param start first game
+ * @param end game after the last one
+ * @param interval games between 2 checkpoints
+ * @return none, the process exits
+ */
+static void work(int fd, int y, unsigned int seed, int level, long start, long end, long interval) {
+	struct checkpoint *c = malloc(sizeof(struct checkpoint));
+	if (c == NULL) {
+		_exit(1);
+	}
+	stats_init(&c->stats, y);
+
+	for (long game = start; game < end; ++game) {
+		struct game_result r;
+		struct rng_stream stream = rng_stream(seed, 0, game);
+		struct ai_player *ai = ai_player_start(y, level, SEARCH_CUTOFF, &stream);  /* nothing kept between games */
+		if (ai == NULL) {
+			_exit(1);
+		}
+		sim_play(y, stream, ai_driver, ai, &r);
+		ai_player_stop(ai);
+		stats_add(&c->stats, &r);
+
+		if ((game + 1 - start) % interval == 0 || game + 1 == end) {
+			c->next = game + 1;
+			if (write_all(fd, c, sizeof(*c)) == false) {
+				_exit(1);
+			}
+			stats_init(&c->stats, y);
+		}
+	}
+	_exit(0);
+}
+
+/** @brief Start the worker of a shard from the games it has not sent yet.
+ * @param s the shard
+ * @param cpus the CPUs of the worker, NULL to not pin it
+ * @param y colum length of game board
+ * @param seed seed of the run
+ * @param level index of the AI level in ai_levels
+ * @param interval games between 2 checkpoints
+ * @return false if the process cannot be created
+ */
+static bool start_worker(struct shard *s, const cpu_set_t *cpus, int y, unsigned int seed, int level,
+	long interval) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return false;
+	}
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	if (pid == 0) {
+		close(fds[0]);
+		if (cpus != NULL && sched_setaffinity(0, sizeof(cpu_set_t), cpus) != 0) {
+			perror("sched_setaffinity");
+		}
+		work(fds[1], y, seed, level, s->next, s->end, interval);
+	}
+	close(fds[1]);
+	s->pid = pid;
+	s->fd = fds[0];
+	return true;
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	int workers = sysconf(_SC_NPROCESSORS_ONLN), y = 4, level = 3;
+	long games = 10000, interval = 100;
+	unsigned int seed = 1;
+	bool by_node = false;
+	const char *summary = NULL;
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "-w") == 0) {
+			workers = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-g") == 0) {
+			games = atol(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-y") == 0) {
+			y = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			seed = strtoul(argv[++i], NULL, 10);
+		} else if (i + 1 < argc && strcmp(argv[i], "-l") == 0) {
+			level = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+			interval = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-n") == 0) {
+			by_node = true;
+		} else if (i + 1 < argc && strcmp(argv[i], "-d") == 0) {
+			summary = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [-w workers] [-g games] [-y size] [-s seed] [-l level] "
+				"[-c games] [-n] [-d summary]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (workers < 1 || workers > SHARD_MAX_WORKERS || games < workers || y < 3 || y > MAX_LENGTH
+		|| level < 1 || level > AI_LEVELS || interval < 1) {
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	/* the CPUs of every worker: one CPU each, or one NUMA node each */
+	static cpu_set_t nodes[SHARD_MAX_NODES];
+	cpu_set_t *cpus = malloc(workers * sizeof(cpu_set_t));
+	int count = by_node ? read_nodes(nodes) : 0;
+	int online = sysconf(_SC_NPROCESSORS_ONLN);
+	for (int w = 0; w < workers; ++w) {
+		if (count > 0) {
+			cpus[w] = nodes[w % count];
+		} else {
+			CPU_ZERO(&cpus[w]);
+			CPU_SET(w % online, &cpus[w]);
+		}
+	}
+	if (by_node == true && count == 0) {
+		fprintf(stderr, "no NUMA node found, pinning to CPUs\n");
+	}
+
+	/* the games are split in contiguous ranges of seeds */
+	struct shard *shards = calloc(workers, sizeof(struct shard));
+	for (int w = 0; w < workers; ++w) {
+		shards[w].next = games * w / workers;
+		shards[w].end = games * (w + 1) / workers;
+		stats_init(&shards[w].stats, y);
+		if (start_worker(&shards[w], &cpus[w], y, seed, level - 1, interval) == false) {
+			perror("fork");
+			return 1;
+		}
+	}
+
+	/* collect the checkpoints until every worker has sent all its games */
+	struct checkpoint *c = malloc(sizeof(struct checkpoint));
+	struct pollfd *polls = malloc(workers * sizeof(struct pollfd));
+	int running = workers, status = 0;
+	while (running > 0) {
+		for (int w = 0; w < workers; ++w) {
+			polls[w].fd = shards[w].fd;
+			polls[w].events = POLLIN;
+		}
+		if (poll(polls, workers, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("poll");
+			return 1;
+		}
+
+		for (int w = 0; w < workers; ++w) {
+			struct shard *s = &shards[w];
+			if (s->fd < 0 || (polls[w].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+				continue;
+			}
+			if (read_all(s->fd, c, sizeof(*c)) == true && c->next > s->next && c->next <= s->end) {
+				stats_merge(&s->stats, &c->stats);
+				s->next = c->next;
+				s->restarts = 0;
+				continue;
+			}
+
+			/* the pipe is closed: the worker has finished or crashed */
+			int exit_status;
+			close(s->fd);
+			s->fd = -1;
+			waitpid(s->pid, &exit_status, 0);
+			if (s->next == s->end) {
+				running--;
+				continue;
+			}
+			fprintf(stderr, "worker %d stopped (%s %d) at game %ld, ", w,
+				WIFSIGNALED(exit_status) ? "signal" : "status",
+				WIFSIGNALED(exit_status) ? WTERMSIG(exit_status) : WEXITSTATUS(exit_status), s->next);
+			if (++s->restarts > SHARD_RESTARTS
+				|| start_worker(s, &cpus[w], y, seed, level - 1, interval) == false) {
+				fprintf(stderr, "giving up its games\n");
+				running--;
+				status = 1;
+			} else {
+				fprintf(stderr, "restarted from its last checkpoint\n");
+			}
+		}
+	}
+
+	struct stats *total = &shards[0].stats;
+	for (int w = 1; w < workers; ++w) {
+		stats_merge(total, &shards[w].stats);
+	}
+	printf("%lld games of level %d (%s) on %dx%d, %d workers\n", total->games, level,
+		ai_levels[level - 1].name, y, y, workers);
+	printf("score: mean %.1f, p50 %.0f, p99 %.0f, max %lld\n", stats_mean(total, STATS_SCORE),
+		stats_quantile(total, STATS_SCORE, 0.5), stats_quantile(total, STATS_SCORE, 0.99), total->max[STATS_SCORE]);
+	printf("biggest tile:");
+	for (int e = 0; e < STATS_TILES; ++e) {
+		if (total->tiles[e] > 0) {
+			printf(" %d (%.1f%%)", 1 << e, 100.0 * total->tiles[e] / total->games);
+		}
+	}
+	printf("\n");
+	if (summary != NULL && stats_save(summary, total) == false) {
+		fprintf(stderr, "cannot write %s\n", summary);
+		status = 1;
+	}
+
+	free(polls);
+	free(c);
+	free(shards);
+	free(cpus);
+	return status;
+}
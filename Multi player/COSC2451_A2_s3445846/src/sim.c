@@ -0,0 +1,62 @@
+/** @file sim.c
+ * @brief This file plays whole games without the user interface,
+ * for the tools that measure or train the AI.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include "key_algorithm.h"
+#include "rng.h"
+#include "sim.h"
+
+/** @brief Seed of a game for the AIs keeping their own random state
+ * (the new numbers come from rng_stream()), so a run of many games is
+ * repeated exactly whatever the number of threads playing them.
+ * @param seed seed of the run
+ * @param round round of the run (generation of the tuner...)
+ * @param game index of the game in the round
+ * @return the seed
+ */
+unsigned int sim_seed(unsigned int seed, int round, long game) {
+	unsigned int h = seed * 2654435761u ^ (round + 1) * 40503u ^ (unsigned int) (game + 1) * 2246822519u;
+	h ^= h >> 15;
+	h *= 2246822519u;
+	return h ^ (h >> 13);
+}
+
+/** @brief Play a game until no move is left.
+ * @param y colum length of game board
+ * @param stream random numbers of the game (rng_stream()), the same stream gives the same game
+ * @param policy function choosing the direction of the next move (-1 to give up)
+ * @param ctx data given to the policy
+ * @param r the result of the game
+ * @return none
+ */
+void sim_play(int y, struct rng_stream stream, int (*policy)(void *ctx, const unsigned char *a, int y),
+	void *ctx, struct game_result *r) {
+	const struct moves *moves = get_moves(y);
+	unsigned char table[MAX_LENGTH * MAX_LENGTH];
+	bool isFail = false;
+
+	memset(table, 0, sizeof(table));
+	memset(r, 0, sizeof(*r));
+	add_value_at(table, &isFail, &y, &stream, 0);
+	add_value_at(table, &isFail, &y, &stream, 1);
+
+	while (r->moves < SIM_MAX_MOVES) {
+		int dir = policy(ctx, table, y);
+		if (dir < 0 || move_table(moves, dir, table, &r->score, &y) == false) {
+			break;  /* the policy has no move left */
+		}
+		r->moves++;
+		add_value_at(table, &isFail, &y, &stream, r->moves + 1);
+	}
+
+	for (int i = 0; i < y * y; ++i) {
+		if (table[i] > r->max_tile) {
+			r->max_tile = table[i];
+		}
+	}
+	memcpy(r->board, table, y * y);
+}
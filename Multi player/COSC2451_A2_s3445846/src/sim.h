@@ -0,0 +1,12 @@
+#define SIM_MAX_MOVES 10000000L  /* stop a game that never ends */
+
+/** @struct Result of a game played without the user interface.
+ */
+struct game_result {
+	long long score; int max_tile; long moves;  /* max_tile is an exponent of 2 */
+	unsigned char board[64];  /* the last board */
+};
+
+unsigned int sim_seed(unsigned int seed, int round, long game);
+void sim_play(int y, struct rng_stream stream, int (*policy)(void *ctx, const unsigned char *a, int y),
+	void *ctx, struct game_result *r);
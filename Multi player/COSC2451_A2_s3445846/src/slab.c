@@ -0,0 +1,119 @@
+/** @file slab.c
+ * @brief This file keeps the many small objects of the server (sessions
+ * and connections): they are cut from big chunks and the freed ones are
+ * handed out again, so opening and closing games does not call malloc()
+ * and the memory of a game stays next to the others.
+ *
+ * Every object starts with a link: the next free object while it is
+ * free, SLAB_USED while it is used, so an id sent by a client can be
+ * checked before it is trusted.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "slab.h"
+
+#define SLAB_USED (SLAB_NONE - 1)
+
+/** @brief Prepare a slab, it takes no memory before the first object.
+ * @param slab the slab
+ * @param size bytes of an object
+ * @param limit most objects at once
+ * @return none
+ */
+void slab_init(struct slab *slab, size_t size, uint32_t limit) {
+	slab->size = (sizeof(uint64_t) + size + 15) & ~(size_t) 15;  /* the link, then the object on 16 bytes */
+	slab->chunks = NULL;
+	slab->count = 0;
+	slab->capacity = 0;
+	slab->free = SLAB_NONE;
+	slab->used = 0;
+	slab->limit = limit < SLAB_USED - SLAB_CHUNK ? limit : SLAB_USED - SLAB_CHUNK;  /* every id stays below SLAB_USED */
+}
+
+/** @brief Get the link of an object.
+ * @param slab the slab
+ * @param id the object
+ * @return the link
+ */
+static uint32_t *link_of(const struct slab *slab, uint32_t id) {
+	return (uint32_t *) (slab->chunks[id / SLAB_CHUNK] + (size_t) (id % SLAB_CHUNK) * slab->size);
+}
+
+/** @brief Take a free object, a new chunk is added when there is none.
+ * @param slab the slab
+ * @param id the id of the object
+ * @return the object filled with zeros, NULL if the limit is reached or there is no memory
+ */
+void *slab_alloc(struct slab *slab, uint32_t *id) {
+	if (slab->used >= slab->limit) {  /* the chunks may hold more objects than the limit */
+		return NULL;
+	}
+	if (slab->free == SLAB_NONE) {
+		if (slab->count / SLAB_CHUNK == slab->capacity) {
+			uint32_t capacity = slab->capacity > 0 ? slab->capacity * 2 : 16;
+			unsigned char **chunks = realloc(slab->chunks, capacity * sizeof(*chunks));
+			if (chunks == NULL) {
+				return NULL;
+			}
+			slab->chunks = chunks;
+			slab->capacity = capacity;
+		}
+		unsigned char *chunk = malloc(SLAB_CHUNK * slab->size);
+		if (chunk == NULL) {
+			return NULL;
+		}
+		slab->chunks[slab->count / SLAB_CHUNK] = chunk;
+		for (uint32_t i = SLAB_CHUNK; i-- > 0;) {  /* the first object of the chunk is used first */
+			*link_of(slab, slab->count + i) = slab->free;
+			slab->free = slab->count + i;
+		}
+		slab->count += SLAB_CHUNK;
+	}
+
+	*id = slab->free;
+	uint32_t *link = link_of(slab, *id);
+	slab->free = *link;
+	slab->used++;
+	*link = SLAB_USED;
+	memset(link + 2, 0, slab->size - sizeof(uint64_t));
+	return link + 2;
+}
+
+/** @brief Get a used object from its id.
+ * @param slab the slab
+ * @param id the id, it may come from a client
+ * @return the object, NULL if the id is not a used object
+ */
+void *slab_get(const struct slab *slab, uint32_t id) {
+	if (id >= slab->count) {
+		return NULL;
+	}
+	uint32_t *link = link_of(slab, id);
+	return *link == SLAB_USED ? link + 2 : NULL;
+}
+
+/** @brief Give an object back, the last freed one is the next taken.
+ * @param slab the slab
+ * @param id the id of a used object
+ * @return none
+ */
+void slab_free(struct slab *slab, uint32_t id) {
+	uint32_t *link = link_of(slab, id);
+	*link = slab->free;
+	slab->free = id;
+	slab->used--;
+}
+
+/** @brief Free every chunk, the objects cannot be used any more.
+ * @param slab the slab
+ * @return none
+ */
+void slab_destroy(struct slab *slab) {
+	for (uint32_t i = 0; i < slab->count / SLAB_CHUNK; ++i) {
+		free(slab->chunks[i]);
+	}
+	free(slab->chunks);
+	slab_init(slab, slab->size - sizeof(uint64_t), slab->limit);
+}
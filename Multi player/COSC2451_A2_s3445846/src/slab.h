@@ -0,0 +1,20 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#define SLAB_CHUNK 4096  /* objects allocated at once */
+#define SLAB_NONE UINT32_MAX  /* id of no object */
+
+/** @struct Objects of one size, allocated by chunks that never move and
+ * reused through a free list, so an object is also known by a small id.
+ */
+struct slab {
+	size_t size;  /* bytes of an object with its link */
+	unsigned char **chunks; uint32_t count; uint32_t capacity;  /* count: objects in the chunks */
+	uint32_t free; uint32_t used; uint32_t limit;  /* free: first free object, limit: most objects */
+};
+
+void slab_init(struct slab *slab, size_t size, uint32_t limit);
+void *slab_alloc(struct slab *slab, uint32_t *id);
+void *slab_get(const struct slab *slab, uint32_t id);
+void slab_free(struct slab *slab, uint32_t id);
+void slab_destroy(struct slab *slab);
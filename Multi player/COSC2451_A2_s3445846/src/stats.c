@@ -0,0 +1,273 @@
+/** @file stats.c
+ * @brief This file summarizes the games of long simulation runs without
+ * keeping them: histograms of the score, the moves and the biggest tile,
+ * the tiles of every slot at the end of the games and quantile sketches.
+ * Every thread fills its own summary and the summaries are added at the
+ * end. They are saved as short text files (only the counts that are not
+ * 0), which are loaded and added again to merge several runs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "rng.h"
+#include "sim.h"
+#include "stats.h"
+
+/** @brief Start an empty summary.
+ * @param s the summary
+ * @param y colum length of game board
+ * @return none
+ */
+void stats_init(struct stats *s, int y) {
+	memset(s, 0, sizeof(*s));
+	s->y = y;
+}
+
+/** @brief Get the bucket of the sketch of a value: bucket i > 0 holds the
+ * values above gamma^(i - 2) up to gamma^(i - 1), gamma = (1 + a) / (1 - a).
+ * @param value the value
+ * @return int
+ */
+static int sketch_bin(long long value) {
+	if (value <= 0) {
+		return 0;
+	}
+	double gamma = (1 + STATS_ACCURACY) / (1 - STATS_ACCURACY);
+	int i = 1 + (int) ceil(log((double) value) / log(gamma));
+	return i < STATS_SKETCH_BINS ? i : STATS_SKETCH_BINS - 1;
+}
+
+/** @brief Get the value standing for a bucket of the sketch, within
+ * STATS_ACCURACY of every value of the bucket.
+ * @param i the bucket
+ * @return double
+ */
+static double sketch_value(int i) {
+	if (i == 0) {
+		return 0;
+	}
+	double gamma = (1 + STATS_ACCURACY) / (1 - STATS_ACCURACY);
+	return 2 * pow(gamma, i - 1) / (gamma + 1);
+}
+
+/** @brief Get the bucket of a histogram by powers of 2.
+ * @param value the value
+ * @return int
+ */
+static int log2_bin(long long value) {
+	int i = 0;
+	while (value > 0 && i < STATS_LOG2_BINS - 1) {
+		value >>= 1;
+		i++;
+	}
+	return i;
+}
+
+/** @brief Count a game.
+ * @param s the summary
+ * @param r the result of the game
+ * @return none
+ */
+void stats_add(struct stats *s, const struct game_result *r) {
+	long long values[2] = {r->score, r->moves};
+	for (int w = 0; w < 2; ++w) {
+		s->sum[w] += values[w];
+		s->squares[w] += (double) values[w] * values[w];
+		if (s->games == 0 || values[w] < s->min[w]) {
+			s->min[w] = values[w];
+		}
+		if (s->games == 0 || values[w] > s->max[w]) {
+			s->max[w] = values[w];
+		}
+		s->log2[w][log2_bin(values[w])]++;
+		s->sketch[w][sketch_bin(values[w])]++;
+	}
+	s->tiles[r->max_tile < STATS_TILES ? r->max_tile : STATS_TILES - 1]++;
+	for (int i = 0; i < s->y * s->y; ++i) {
+		s->heat[i][r->board[i] < STATS_TILES ? r->board[i] : STATS_TILES - 1]++;
+	}
+	s->games++;
+}
+
+/** @brief Add a summary to another one.
+ * @param into the summary receiving the counts
+ * @param from the summary added
+ * @return false if the board sizes differ
+ */
+bool stats_merge(struct stats *into, const struct stats *from) {
+	if (into->y != from->y) {
+		return false;
+	}
+	for (int w = 0; w < 2 && from->games > 0; ++w) {
+		if (into->games == 0 || from->min[w] < into->min[w]) {
+			into->min[w] = from->min[w];
+		}
+		if (into->games == 0 || from->max[w] > into->max[w]) {
+			into->max[w] = from->max[w];
+		}
+		into->sum[w] += from->sum[w];
+		into->squares[w] += from->squares[w];
+		for (int i = 0; i < STATS_LOG2_BINS; ++i) {
+			into->log2[w][i] += from->log2[w][i];
+		}
+		for (int i = 0; i < STATS_SKETCH_BINS; ++i) {
+			into->sketch[w][i] += from->sketch[w][i];
+		}
+	}
+	for (int e = 0; e < STATS_TILES; ++e) {
+		into->tiles[e] += from->tiles[e];
+		for (int i = 0; i < STATS_SLOTS; ++i) {
+			into->heat[i][e] += from->heat[i][e];
+		}
+	}
+	into->games += from->games;
+	return true;
+}
+
+/** @brief Get the mean score or number of moves.
+ * @param s the summary
+ * @param what STATS_SCORE or STATS_MOVES
+ * @return double
+ */
+double stats_mean(const struct stats *s, int what) {
+	return s->games > 0 ? s->sum[what] / s->games : 0;
+}
+
+/** @brief Get a quantile of the score or of the number of moves.
+ * @param s the summary
+ * @param what STATS_SCORE or STATS_MOVES
+ * @param q the quantile (0 to 1)
+ * @return double
+ */
+double stats_quantile(const struct stats *s, int what, double q) {
+	if (s->games == 0) {
+		return 0;
+	}
+	long long rank = (long long) (q * (s->games - 1)), seen = 0;
+	for (int i = 0; i < STATS_SKETCH_BINS; ++i) {
+		seen += s->sketch[what][i];
+		if (seen > rank) {
+			double v = sketch_value(i);  /* the exact bounds are better than the buckets */
+			return v < s->min[what] ? s->min[what] : v > s->max[what] ? s->max[what] : v;
+		}
+	}
+	return s->max[what];
+}
+
+/** @brief Write the counts of an array that are not 0, on one line.
+ * @param f the file
+ * @param name name of the line
+ * @param counts the counts
+ * @param n number of counts
+ * @return none
+ */
+static void write_counts(FILE *f, const char *name, const long long *counts, int n) {
+	int used = 0;
+	for (int i = 0; i < n; ++i) {
+		used += counts[i] != 0;
+	}
+	fprintf(f, "%s %d", name, used);
+	for (int i = 0; i < n; ++i) {
+		if (counts[i] != 0) {
+			fprintf(f, " %d:%lld", i, counts[i]);
+		}
+	}
+	fprintf(f, "\n");
+}
+
+/** @brief Read a line written by write_counts().
+ * @param f the file
+ * @param name name of the line
+ * @param counts the counts, the others are left at 0
+ * @param n number of counts
+ * @return false if the line is not valid
+ */
+static bool read_counts(FILE *f, const char *name, long long *counts, int n) {
+	char word[32];
+	int used, i;
+	long long count;
+	if (fscanf(f, "%31s %d", word, &used) != 2 || strcmp(word, name) != 0 || used < 0 || used > n) {
+		return false;
+	}
+	for (int k = 0; k < used; ++k) {
+		if (fscanf(f, "%d:%lld", &i, &count) != 2 || i < 0 || i >= n) {
+			return false;
+		}
+		counts[i] = count;
+	}
+	return true;
+}
+
+/** @brief Write a summary, the old file is only replaced once the new one is complete.
+ * @param path the file
+ * @param s the summary
+ * @return false if the file cannot be written
+ */
+bool stats_save(const char *path, const struct stats *s) {
+	char temp[512];
+	snprintf(temp, sizeof(temp), "%s.tmp", path);
+	FILE *f = fopen(temp, "w");
+	if (!f) {
+		return false;
+	}
+
+	const char *names[2] = {"score", "moves"};
+	fprintf(f, "stats %d\ny %d\ngames %lld\n", STATS_FILE_VERSION, s->y, s->games);
+	for (int w = 0; w < 2; ++w) {
+		char name[32];
+		fprintf(f, "%s %.17g %.17g %lld %lld\n", names[w], s->sum[w], s->squares[w], s->min[w], s->max[w]);
+		snprintf(name, sizeof(name), "%s_log2", names[w]);
+		write_counts(f, name, s->log2[w], STATS_LOG2_BINS);
+		snprintf(name, sizeof(name), "%s_sketch", names[w]);
+		write_counts(f, name, s->sketch[w], STATS_SKETCH_BINS);
+	}
+	write_counts(f, "tiles", s->tiles, STATS_TILES);
+	for (int i = 0; i < s->y * s->y; ++i) {
+		write_counts(f, "heat", s->heat[i], STATS_TILES);
+	}
+
+	if (fclose(f) != 0) {
+		return false;
+	}
+	return rename(temp, path) == 0;
+}
+
+/** @brief Read a summary.
+ * @param path the file
+ * @param s the summary
+ * @return false if there is no valid summary
+ */
+bool stats_load(const char *path, struct stats *s) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return false;
+	}
+
+	int version, y;
+	bool ok = fscanf(f, "stats %d\ny %d\n", &version, &y) == 2 && version == STATS_FILE_VERSION
+		&& y >= 3 && y * y <= STATS_SLOTS;
+	if (ok == true) {
+		stats_init(s, y);
+		ok = fscanf(f, "games %lld\n", &s->games) == 1;
+	}
+	const char *names[2] = {"score", "moves"};
+	for (int w = 0; w < 2 && ok; ++w) {
+		char word[32], name[32];
+		ok = fscanf(f, "%31s %lf %lf %lld %lld", word, &s->sum[w], &s->squares[w], &s->min[w], &s->max[w]) == 5
+			&& strcmp(word, names[w]) == 0;
+		snprintf(name, sizeof(name), "%s_log2", names[w]);
+		ok = ok && read_counts(f, name, s->log2[w], STATS_LOG2_BINS);
+		snprintf(name, sizeof(name), "%s_sketch", names[w]);
+		ok = ok && read_counts(f, name, s->sketch[w], STATS_SKETCH_BINS);
+	}
+	ok = ok && read_counts(f, "tiles", s->tiles, STATS_TILES);
+	for (int i = 0; i < y * y && ok; ++i) {
+		ok = read_counts(f, "heat", s->heat[i], STATS_TILES);
+	}
+
+	fclose(f);
+	return ok;
+}
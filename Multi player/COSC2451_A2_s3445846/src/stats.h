@@ -0,0 +1,32 @@
+#include <stdbool.h>
+
+#define STATS_FILE_VERSION 1
+#define STATS_LOG2_BINS 64  /* 0, then 1, 2-3, 4-7, ... */
+#define STATS_TILES 32  /* exponents of the tiles */
+#define STATS_SLOTS 64  /* slots of the biggest board */
+#define STATS_SKETCH_BINS 2048  /* buckets of the quantile sketch */
+#define STATS_ACCURACY 0.01  /* relative error of the quantiles */
+
+/* what a histogram or a sketch counts */
+enum { STATS_SCORE, STATS_MOVES };
+
+/** @struct Summary of many games of one board size. It only holds counts
+ * and sums, so 2 summaries are merged by adding them.
+ * The quantile sketch counts the values in buckets growing by a fixed
+ * ratio, any quantile is then known within STATS_ACCURACY.
+ */
+struct stats {
+	int y; long long games;
+	double sum[2]; double squares[2]; long long min[2]; long long max[2];
+	long long log2[2][STATS_LOG2_BINS]; long long sketch[2][STATS_SKETCH_BINS];
+	long long tiles[STATS_TILES];  /* biggest tile of the games */
+	long long heat[STATS_SLOTS][STATS_TILES];  /* tiles of the last boards, per slot */
+};
+
+void stats_init(struct stats *s, int y);
+void stats_add(struct stats *s, const struct game_result *r);
+bool stats_merge(struct stats *into, const struct stats *from);
+double stats_mean(const struct stats *s, int what);
+double stats_quantile(const struct stats *s, int what, double q);
+bool stats_save(const char *path, const struct stats *s);
+bool stats_load(const char *path, struct stats *s);
@@ -0,0 +1,254 @@
+/** @file think.c
+ * @brief This program plays games with the expectimax search given a
+ * deadline per move, and prints how deep it goes, how fast, and how long
+ * the moves really take (the latency must stay under the deadline).
+ *
+ * Usage: ./think [-d ms] [-y size] [-g games] [-m moves] [-s seed] [-n network]
+ *                [-p cutoff] [-f] [-r | -c] [-k depth] [-l level]
+ * (default: -d 100 -y 4 -g 1 -m 1000 -p 0.0001, the evaluation scores the boards,
+ * -f searches as deep as the deadline allows instead of following the depth schedule,
+ * -r keys the cache by the board only instead of its 8 symmetries, -c searches without a cache,
+ * -k searches every board of the games again at a fixed depth with both keys of the cache
+ * and compares the hits, -l plays an AI level from 1 to 6 with its own evaluation and nodes,
+ * -d still limits its time, -d 0 lets it use all its nodes)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "key_algorithm.h"
+#include "eval.h"
+#include "ntuple.h"
+#include "search.h"
+#include "rng.h"
+#include "sim.h"
+#include "ai.h"
+
+/** @struct Policy of the search, with the report of every move.
+ */
+struct thinker {
+	struct search *s; struct ai_player *player; int budget_ms; long limit;  /* limit: moves of a game */
+	long moves; long count; double *ms; bool *crowded;  /* crowded: a quarter of the slots or less are empty */
+	unsigned char *boards;
+	long depths[SEARCH_MAX_DEPTH + 1]; long nodes; double total_ms;
+};
+
+/** @brief Choose a move with search_deadline() or the AI level and keep its report.
+ * @param ctx the thinker
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction, -1 to stop the game
+ */
+static int think(void *ctx, const unsigned char *a, int y) {
+	struct thinker *t = ctx;
+	struct search_report report;
+	if (t->moves++ >= t->limit) {
+		return -1;
+	}
+
+	int dir;
+	if (t->player != NULL) {
+		dir = ai_player_choose(t->player, a, t->budget_ms, &report);
+	} else {
+		dir = search_deadline(t->s, a, t->budget_ms, 0, &report);
+	}
+	int empty = 0;
+	for (int i = 0; i < y * y; ++i) {
+		empty += a[i] == 0;
+	}
+	t->ms = realloc(t->ms, (t->count + 1) * sizeof(*t->ms));
+	t->crowded = realloc(t->crowded, (t->count + 1) * sizeof(*t->crowded));
+	t->ms[t->count] = report.ms;
+	t->crowded[t->count] = empty * 4 <= y * y;
+	t->boards = realloc(t->boards, (t->count + 1) * y * y);
+	memcpy(t->boards + t->count * y * y, a, y * y);
+	t->count++;
+	t->depths[report.depth]++;
+	t->nodes += report.nodes;
+	t->total_ms += report.ms;
+	return dir;
+}
+
+/** @brief Get the current time in seconds.
+ * @return double
+ */
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/** @brief Compare 2 latencies for qsort().
+ * @param a the first latency
+ * @param b the second latency
+ * @return int
+ */
+static int compare(const void *a, const void *b) {
+	double x = *(const double *) a, y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+/** @brief Get a percentile of sorted latencies.
+ * @param ms the sorted latencies
+ * @param count number of latencies
+ * @param p the percentile (0 to 100)
+ * @return double
+ */
+static double percentile(const double *ms, long count, double p) {
+	if (count == 0) {
+		return 0;
+	}
+	long i = (long) (p / 100 * count);
+	return ms[i < count ? i : count - 1];
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	int budget_ms = 100, y = 4, games = 1, keys = 0, level = 0;
+	long limit = 1000;
+	unsigned int seed = 1;
+	const char *file = NULL;
+	float cutoff = SEARCH_CUTOFF;
+	bool schedule = true, canonical = true, cache = true;
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "-d") == 0) {
+			budget_ms = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-y") == 0) {
+			y = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-g") == 0) {
+			games = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+			limit = atol(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			seed = strtoul(argv[++i], NULL, 10);
+		} else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+			file = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-p") == 0) {
+			cutoff = atof(argv[++i]);
+		} else if (strcmp(argv[i], "-f") == 0) {
+			schedule = false;
+		} else if (strcmp(argv[i], "-r") == 0) {
+			canonical = false;
+		} else if (strcmp(argv[i], "-c") == 0) {
+			cache = false;
+		} else if (i + 1 < argc && strcmp(argv[i], "-k") == 0) {
+			keys = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-l") == 0) {
+			level = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "usage: %s [-d ms] [-y size] [-g games] [-m moves] [-s seed] [-n network] "
+				"[-p cutoff] [-f] [-r | -c] [-k depth] [-l level]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (budget_ms < 0 || (budget_ms == 0 && level == 0) || y < 3 || y > MAX_LENGTH || games < 1 || limit < 1
+		|| cutoff < 0 || cutoff >= 1 || keys < 0 || keys > SEARCH_MAX_DEPTH || level < 0 || level > AI_LEVELS) {
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	struct weights w;
+	struct evaluator evaluator;
+	struct ntuple network;
+	eval_default_weights(&w);
+	eval_load_weights(EVAL_FILE, &w);
+	eval_init(&evaluator, y, &w);
+	if (file != NULL && (ntuple_open(&network, file, false) == false || network.y != y)) {
+		fprintf(stderr, "%s is not a network of %dx%d boards\n", file, y, y);
+		return 1;
+	}
+
+	struct search s;
+	struct thinker t;
+	memset(&t, 0, sizeof(t));
+	search_init(&s, y, &evaluator, file != NULL ? &network : NULL);
+	s.cutoff = cutoff;
+	s.schedule = schedule;
+	s.canonical = canonical;
+	if (cache == false) {
+		search_free(&s);
+	}
+	t.s = &s;
+	if (level > 0) {
+		struct rng_stream stream = rng_stream(seed, 1, 0);  /* the moves of the Beginner level */
+		t.player = ai_player_start(y, level - 1, cutoff, &stream);
+		printf("level %d (%s): %ld nodes per move\n", level, ai_levels[level - 1].name, ai_levels[level - 1].nodes);
+	}
+	t.budget_ms = budget_ms;
+	t.limit = limit;
+
+	printf("%5s %10s %9s %7s\n", "game", "score", "max tile", "moves");
+	for (int g = 0; g < games; ++g) {
+		struct game_result r;
+		t.moves = 0;
+		sim_play(y, rng_stream(seed, 0, g), think, &t, &r);
+		printf("%5d %10lld %9d %7ld\n", g + 1, r.score, 1 << r.max_tile, r.moves);
+	}
+
+	/* the latency of the crowded boards, then of every board */
+	double *crowded = malloc((t.count + 1) * sizeof(*crowded));
+	long n = 0;
+	for (long i = 0; i < t.count; ++i) {
+		if (t.crowded[i] == true) {
+			crowded[n++] = t.ms[i];
+		}
+	}
+	qsort(crowded, n, sizeof(*crowded), compare);
+	qsort(t.ms, t.count, sizeof(*t.ms), compare);
+
+	printf("\ndepth reached:");
+	for (int d = 1; d <= SEARCH_MAX_DEPTH; ++d) {
+		if (t.depths[d] > 0) {
+			printf(" %d (%.1f%%)", d, 100.0 * t.depths[d] / t.count);
+		}
+	}
+	printf("\nnodes/sec: %.0f, nodes/move: %.0f\n", t.total_ms > 0 ? t.nodes / t.total_ms * 1000 : 0.0,
+		t.count > 0 ? (double) t.nodes / t.count : 0.0);
+	printf("cache: %ld lookups, %.1f%% hits\n", s.lookups, s.lookups > 0 ? 100.0 * s.hits / s.lookups : 0.0);
+	printf("latency ms (deadline %d): p50 %.2f, p99 %.2f, max %.2f\n", budget_ms,
+		percentile(t.ms, t.count, 50), percentile(t.ms, t.count, 99), percentile(t.ms, t.count, 100));
+	printf("crowded boards (%ld moves): p99 %.2f, max %.2f\n", n,
+		percentile(crowded, n, 99), percentile(crowded, n, 100));
+
+	/* the same searches with the board as key, then with the symmetries sharing a key */
+	if (keys > 0) {
+		printf("\n");
+	}
+	for (int k = 0; k < 2 && keys > 0; ++k) {
+		struct search c;
+		search_init(&c, y, &evaluator, file != NULL ? &network : NULL);
+		c.cutoff = cutoff;
+		c.canonical = k == 1;
+		double start = now();
+		for (long i = 0; i < t.count; ++i) {
+			search_best(&c, t.boards + i * y * y, keys, NULL);
+		}
+		printf("depth %d, keyed by %-10s %5.1f%% hits, %ld nodes, %.0f ms\n", keys,
+			k == 0 ? "board:" : "symmetry:", c.lookups > 0 ? 100.0 * c.hits / c.lookups : 0.0,
+			c.nodes, (now() - start) * 1000);
+		search_free(&c);
+	}
+
+	free(crowded);
+	free(t.boards);
+	free(t.ms);
+	free(t.crowded);
+	search_free(&s);
+	if (t.player != NULL) {
+		ai_player_stop(t.player);
+	}
+	if (file != NULL) {
+		ntuple_close(&network);
+	}
+	eval_free(&evaluator);
+	return 0;
+}
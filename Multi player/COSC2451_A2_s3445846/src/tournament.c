@@ -0,0 +1,580 @@
+/** @file tournament.c
+ * @brief This program compares the AIs: every player plays the same
+ * seeded games on all cores, then every pair of players is matched game
+ * by game (the higher score wins the game). It prints the scores, the
+ * distribution of the biggest tile, the win rates and their 95%
+ * confidence intervals as CSV or JSON.
+ * Every few games the results played so far are written to a checkpoint
+ * by a forked child, and --resume only plays the games it is missing
+ * with the options it was started with.
+ *
+ * Usage: ./tournament [-p players] [-g games] [-y size] [-t threads]
+ *                     [-s seed] [-b ms] [-f csv|json] [-d prefix]
+ *                     [-c checkpoint] [-k games] [--resume]
+ * (default: -p random,medium,smart -g 100 -y 4 -s 1 -b 10 -f csv
+ * -c tournament.ckpt -k 100, players: random, medium, greedy, smart, mcts
+ * and level1 to level6, -b is the thinking time of mcts per move, -d writes
+ * the summary of the games of every player to prefix<player>.stats for
+ * ./report, -k counts the games of all players, -k 0 only writes the
+ * checkpoint at the end)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "key_algorithm.h"
+#include "eval.h"
+#include "ntuple.h"
+#include "mcts.h"
+#include "search.h"
+#include "rng.h"
+#include "sim.h"
+#include "stats.h"
+#include "ai.h"
+
+#define MAX_PLAYERS 16
+#define Z95 1.96  /* the normal quantile of a 95% confidence interval */
+#define CHECKPOINT_VERSION 1
+
+/* the AIs of the game without the user interface */
+enum { PLAYER_RANDOM, PLAYER_MEDIUM, PLAYER_GREEDY, PLAYER_SMART, PLAYER_MCTS, PLAYER_LEVEL };
+
+/** @struct Player of the tournament.
+ */
+struct contestant {
+	char name[16]; int kind; int level;  /* level: index in ai_levels for PLAYER_LEVEL */
+};
+
+/** @struct Work shared by the threads, the evaluation and the network are read only.
+ */
+struct tournament {
+	int y; int games; int players; int budget_ms; unsigned int seed;
+	struct contestant contestants[MAX_PLAYERS];
+	struct evaluator evaluator; struct ntuple network; bool use_network;
+	struct game_result *results;  /* player * games + game */
+	int next; pthread_mutex_t lock;
+	const char *summary; struct stats stats[MAX_PLAYERS];  /* summary: prefix of the files, NULL without -d */
+	char list[256]; bool *played; int finished;  /* list: the players, played: the games in the results */
+	const char *path; int every; pid_t writer; bool due;  /* the checkpoint, every: games between 2 checkpoints */
+	char temp[512];  /* the checkpoint is written there, then renamed */
+};
+
+/** @struct Start of the checkpoint file, followed by the played flags and the results.
+ */
+struct checkpoint_header {
+	char magic[4]; int version; int y; int games; int players; int budget_ms; unsigned int seed;
+	char list[256];
+};
+
+/** @brief Choose a move with the expectimax search of smart_AI in AI vs AI mode.
+ * @param ctx the search (struct search)
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction, -1 if nothing can move
+ */
+static int smart(void *ctx, const unsigned char *a, int y) {
+	return search_best(ctx, a, 2, NULL);
+}
+
+/** @brief Read a player name.
+ * @param name the name (random, medium, greedy, smart, mcts or levelN)
+ * @param c the player
+ * @return false if there is no such player
+ */
+static bool parse_player(const char *name, struct contestant *c) {
+	const char *names[PLAYER_LEVEL] = {"random", "medium", "greedy", "smart", "mcts"};
+	snprintf(c->name, sizeof(c->name), "%s", name);
+	c->level = 0;
+	for (int k = 0; k < PLAYER_LEVEL; ++k) {
+		if (strcmp(name, names[k]) == 0) {
+			c->kind = k;
+			return true;
+		}
+	}
+	c->kind = PLAYER_LEVEL;
+	if (sscanf(name, "level%d", &c->level) != 1 || c->level < 1 || c->level > AI_LEVELS) {
+		return false;
+	}
+	c->level--;
+	return true;
+}
+
+/** @brief Play one game. Every game gets new players, so its result does
+ * not depend on the games played before by the same thread.
+ * @param t the tournament
+ * @param player index of the player
+ * @param game index of the game, the seed of the game is the same for every player
+ * @param r the result
+ * @return none
+ */
+static void play(struct tournament *t, int player, int game, struct game_result *r) {
+	const struct contestant *c = &t->contestants[player];
+	struct rng_stream seed = rng_stream(t->seed, 0, game);
+
+	if (c->kind == PLAYER_RANDOM || c->kind == PLAYER_LEVEL) {  /* random_AI is the Beginner level */
+		struct ai_player *ai = ai_player_start(t->y, c->kind == PLAYER_LEVEL ? c->level : 0, SEARCH_CUTOFF, &seed);
+		sim_play(t->y, seed, ai_driver, ai, r);
+		ai_player_stop(ai);
+	} else if (c->kind == PLAYER_MEDIUM) {
+		int turn = 0;
+		sim_play(t->y, seed, ai_corner, &turn, r);
+	} else if (c->kind == PLAYER_GREEDY) {  /* smart_AI in 1-player mode */
+		if (t->use_network == true) {
+			sim_play(t->y, seed, ai_ntuple, &t->network, r);
+		} else {
+			sim_play(t->y, seed, ai_greedy, &t->evaluator, r);
+		}
+	} else if (c->kind == PLAYER_SMART) {
+		struct search s;
+		search_init(&s, t->y, &t->evaluator, t->use_network ? &t->network : NULL);
+		sim_play(t->y, seed, smart, &s, r);
+		search_free(&s);
+	} else {  /* 1 thread per tree, the games already use all cores */
+		struct mcts *tree = mcts_start(1, t->budget_ms, sim_seed(t->seed, 0, game));
+		if (tree != NULL) {
+			sim_play(t->y, seed, ai_mcts, tree, r);
+			mcts_stop(tree);
+		}
+	}
+}
+
+/** @brief Write a whole block to a file, with write() only: the
+ * checkpoint is written by a child forked from the threads, which must not
+ * use stdio or malloc().
+ * @param fd the file
+ * @param data the block
+ * @param size number of bytes
+ * @return false if the file cannot be written
+ */
+static bool write_all(int fd, const void *data, size_t size) {
+	const unsigned char *bytes = data;
+	while (size > 0) {
+		ssize_t n = write(fd, bytes, size);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		bytes += n;
+		size -= n;
+	}
+	return true;
+}
+
+/** @brief Write the checkpoint: the options, then which games are played
+ * and the results. It is written next to the old one and then renamed.
+ * @param t the tournament
+ * @return false if the file cannot be written
+ */
+static bool save_checkpoint(const struct tournament *t) {
+	struct checkpoint_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, "TOUR", 4);
+	h.version = CHECKPOINT_VERSION;
+	h.y = t->y;
+	h.games = t->games;
+	h.players = t->players;
+	h.budget_ms = t->budget_ms;
+	h.seed = t->seed;
+	memcpy(h.list, t->list, sizeof(h.list));
+
+	int fd = open(t->temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	size_t jobs = (size_t) t->players * t->games;
+	bool ok = write_all(fd, &h, sizeof(h)) && write_all(fd, t->played, jobs * sizeof(bool))
+		&& write_all(fd, t->results, jobs * sizeof(struct game_result)) && fsync(fd) == 0;
+	if (close(fd) != 0 || ok == false) {
+		return false;
+	}
+	return rename(t->temp, t->path) == 0;
+}
+
+/** @brief Read the options of a checkpoint.
+ * @param path the checkpoint file
+ * @param t the tournament, gets the options and the players of the checkpoint
+ * @return false if there is no valid checkpoint
+ */
+static bool load_options(const char *path, struct tournament *t) {
+	struct checkpoint_header h;
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		return false;
+	}
+	bool ok = fread(&h, sizeof(h), 1, f) == 1 && memcmp(h.magic, "TOUR", 4) == 0
+		&& h.version == CHECKPOINT_VERSION && memchr(h.list, 0, sizeof(h.list)) != NULL;
+	fclose(f);
+	if (ok == true) {
+		t->y = h.y;
+		t->games = h.games;
+		t->budget_ms = h.budget_ms;
+		t->seed = h.seed;
+		memcpy(t->list, h.list, sizeof(t->list));
+	}
+	return ok;
+}
+
+/** @brief Read the played games of a checkpoint, the options are the ones
+ * of load_options().
+ * @param t the tournament, its results are allocated
+ * @return false if the checkpoint is not valid
+ */
+static bool load_results(struct tournament *t) {
+	struct checkpoint_header h;
+	FILE *f = fopen(t->path, "rb");
+	if (!f) {
+		return false;
+	}
+	size_t jobs = (size_t) t->players * t->games;
+	bool ok = fread(&h, sizeof(h), 1, f) == 1 && h.players == t->players
+		&& fread(t->played, sizeof(bool), jobs, f) == jobs
+		&& fread(t->results, sizeof(struct game_result), jobs, f) == jobs;
+	fclose(f);
+	for (size_t i = 0; i < jobs && ok; ++i) {
+		t->finished += t->played[i];
+	}
+	return ok;
+}
+
+/** @brief Fork a child writing the checkpoint. The lock is held, so the
+ * played flags it sees only name finished results. The last child must be
+ * done first, they write the same file, but the threads never wait for it.
+ * The other threads may be in the middle of a game when the process is
+ * forked, so the child only makes system calls (save_checkpoint()).
+ * @param t the tournament
+ * @return false if the last child is still writing
+ */
+static bool snapshot(struct tournament *t) {
+	if (t->writer > 0 && waitpid(t->writer, NULL, WNOHANG) == 0) {
+		return false;
+	}
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0) {
+		_exit(save_checkpoint(t) ? 0 : 1);
+	}
+	if (pid < 0) {
+		fprintf(stderr, "cannot fork to write %s\n", t->path);
+	}
+	t->writer = pid;
+	return true;
+}
+
+/** @brief Play the games until there is none left, the games of the
+ * checkpoint are skipped.
+ * @param param the tournament
+ * @return none
+ */
+static void *worker(void *param) {
+	struct tournament *t = param;
+	int jobs = t->players * t->games;
+
+	while (true) {
+		pthread_mutex_lock(&t->lock);
+		int job, game, player;
+		do {
+			job = t->next++;
+			game = job / t->players;  /* the players go through the seeds together */
+			player = job % t->players;
+		} while (job < jobs && t->played[player * t->games + game] == true);
+		pthread_mutex_unlock(&t->lock);
+		if (job >= jobs) {
+			break;
+		}
+
+		play(t, player, game, &t->results[player * t->games + game]);
+
+		pthread_mutex_lock(&t->lock);
+		t->played[player * t->games + game] = true;
+		if (t->every > 0 && ++t->finished % t->every == 0) {
+			t->due = true;
+		}
+		if (t->due == true && t->finished < jobs) {
+			t->due = !snapshot(t);  /* still writing the last one: the next game tries again */
+		}
+		pthread_mutex_unlock(&t->lock);
+	}
+	return NULL;
+}
+
+/** @brief Compare 2 scores for qsort().
+ * @param a the first score
+ * @param b the second score
+ * @return int
+ */
+static int compare(const void *a, const void *b) {
+	long long x = *(const long long *) a, y = *(const long long *) b;
+	return (x > y) - (x < y);
+}
+
+/** @brief Get the Wilson interval of a rate.
+ * @param rate the rate measured
+ * @param n number of trials
+ * @param low the lower bound
+ * @param high the upper bound
+ * @return none
+ */
+static void wilson(double rate, long n, double *low, double *high) {
+	double z2 = Z95 * Z95 / n;
+	double center = (rate + z2 / 2) / (1 + z2);
+	double half = Z95 * sqrt(rate * (1 - rate) / n + z2 / (4.0 * n)) / (1 + z2);
+	*low = center - half;
+	*high = center + half;
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	static struct tournament t;
+	const char *format = "csv";
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	bool resume = false;
+	snprintf(t.list, sizeof(t.list), "random,medium,smart");
+	t.games = 100;
+	t.y = 4;
+	t.seed = 1;
+	t.budget_ms = 10;
+	t.path = "tournament.ckpt";
+	t.every = 100;
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "-p") == 0) {
+			snprintf(t.list, sizeof(t.list), "%s", argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-g") == 0) {
+			t.games = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-y") == 0) {
+			t.y = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+			threads = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			t.seed = strtoul(argv[++i], NULL, 10);
+		} else if (i + 1 < argc && strcmp(argv[i], "-b") == 0) {
+			t.budget_ms = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-f") == 0) {
+			format = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-d") == 0) {
+			t.summary = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+			t.path = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-k") == 0) {
+			t.every = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--resume") == 0) {
+			resume = true;
+		} else {
+			fprintf(stderr, "usage: %s [-p players] [-g games] [-y size] [-t threads] [-s seed] "
+				"[-b ms] [-f csv|json] [-d prefix] [-c checkpoint] [-k games] [--resume]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (resume == true && load_options(t.path, &t) == false) {
+		fprintf(stderr, "cannot resume from %s\n", t.path);
+		return 1;
+	}
+	snprintf(t.temp, sizeof(t.temp), "%s.tmp", t.path);
+	char list[256];
+	memcpy(list, t.list, sizeof(list));  /* strtok() cuts the list */
+	for (char *name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+		if (t.players == MAX_PLAYERS || parse_player(name, &t.contestants[t.players]) == false) {
+			fprintf(stderr, "unknown player %s\n", name);
+			return 1;
+		}
+		t.players++;
+	}
+	bool json = strcmp(format, "json") == 0;
+	if (t.players < 1 || t.games < 2 || t.y < 3 || t.y > MAX_LENGTH || threads < 1 || t.budget_ms < 1
+		|| t.every < 0 || (json == false && strcmp(format, "csv") != 0)) {
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	/* the evaluation and the network of smart_AI, shared by every game */
+	struct weights w;
+	eval_default_weights(&w);
+	eval_load_weights(EVAL_FILE, &w);
+	eval_init(&t.evaluator, t.y, &w);
+	const char *networks[2] = {NTUPLE_QUANTIZED_FILE, NTUPLE_FILE};
+	for (int i = 0; i < 2 && t.use_network == false; i++) {
+		t.use_network = ntuple_open(&t.network, networks[i], false);
+		if (t.use_network == true && t.network.y != t.y) {
+			ntuple_close(&t.network);
+			t.use_network = false;
+		}
+	}
+
+	t.results = calloc((size_t) t.players * t.games, sizeof(struct game_result));
+	t.played = calloc((size_t) t.players * t.games, sizeof(bool));
+	if (t.results == NULL || t.played == NULL) {
+		fprintf(stderr, "no memory for the results\n");
+		return 1;
+	}
+	if (resume == true && load_results(&t) == false) {
+		fprintf(stderr, "cannot resume from %s\n", t.path);
+		return 1;
+	}
+	if (resume == true) {
+		fprintf(stderr, "resuming with %d of %d games played\n", t.finished, t.players * t.games);
+	}
+	pthread_mutex_init(&t.lock, NULL);
+	pthread_t *workers = malloc(threads * sizeof(pthread_t));
+	for (int i = 0; i < threads; ++i) {
+		pthread_create(&workers[i], NULL, worker, &t);
+	}
+	for (int i = 0; i < threads; ++i) {
+		pthread_join(workers[i], NULL);
+	}
+	if (t.writer > 0) {
+		waitpid(t.writer, NULL, 0);
+	}
+	int status = 0;
+	if (save_checkpoint(&t) == false) {
+		fprintf(stderr, "cannot write %s\n", t.path);
+		status = 1;
+	}
+
+	/* the summaries only add the results, the ones of the checkpoint included */
+	for (int p = 0; p < t.players && t.summary != NULL; ++p) {
+		stats_init(&t.stats[p], t.y);
+		for (int g = 0; g < t.games; ++g) {
+			stats_add(&t.stats[p], &t.results[p * t.games + g]);
+		}
+	}
+
+	/* the tiles reached by any player are the columns of the distribution */
+	int low = 63, high = 0;
+	for (long i = 0; i < (long) t.players * t.games; ++i) {
+		low = t.results[i].max_tile < low ? t.results[i].max_tile : low;
+		high = t.results[i].max_tile > high ? t.results[i].max_tile : high;
+	}
+
+	long long *scores = malloc(t.games * sizeof(long long));
+	if (json == true) {
+		printf("{\"size\": %d, \"games\": %d, \"seed\": %u,\n \"players\": [\n", t.y, t.games, t.seed);
+	} else {
+		printf("player,games,mean,median,stddev,mean_ci_low,mean_ci_high,min,max,mean_moves");
+		for (int e = low; e <= high; ++e) {
+			printf(",tile_%d", 1 << e);
+		}
+		printf("\n");
+	}
+	for (int p = 0; p < t.players; ++p) {
+		const struct game_result *r = &t.results[p * t.games];
+		double mean = 0, var = 0, moves = 0;
+		long tiles[64] = {0};
+		for (int g = 0; g < t.games; ++g) {
+			scores[g] = r[g].score;
+			mean += r[g].score;
+			moves += r[g].moves;
+			tiles[r[g].max_tile]++;
+		}
+		mean /= t.games;
+		moves /= t.games;
+		for (int g = 0; g < t.games; ++g) {
+			var += (r[g].score - mean) * (r[g].score - mean);
+		}
+		double sd = sqrt(var / (t.games - 1));
+		double half = Z95 * sd / sqrt(t.games);
+		qsort(scores, t.games, sizeof(long long), compare);
+		double median = t.games % 2 == 1 ? scores[t.games / 2]
+			: (scores[t.games / 2 - 1] + scores[t.games / 2]) / 2.0;
+
+		if (json == true) {
+			printf("  {\"name\": \"%s\", \"mean\": %.1f, \"median\": %.1f, \"stddev\": %.1f, "
+				"\"mean_ci\": [%.1f, %.1f], \"min\": %lld, \"max\": %lld, \"mean_moves\": %.1f, \"max_tile\": {",
+				t.contestants[p].name, mean, median, sd, mean - half, mean + half,
+				scores[0], scores[t.games - 1], moves);
+			bool first = true;
+			for (int e = low; e <= high; ++e) {
+				if (tiles[e] > 0) {
+					printf("%s\"%d\": %ld", first ? "" : ", ", 1 << e, tiles[e]);
+					first = false;
+				}
+			}
+			printf("}}%s\n", p + 1 < t.players ? "," : "");
+		} else {
+			printf("%s,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%lld,%lld,%.1f", t.contestants[p].name, t.games, mean, median,
+				sd, mean - half, mean + half, scores[0], scores[t.games - 1], moves);
+			for (int e = low; e <= high; ++e) {
+				printf(",%ld", tiles[e]);
+			}
+			printf("\n");
+		}
+	}
+
+	/* round robin: every pair is matched on the same seeds */
+	if (json == true) {
+		printf(" ],\n \"pairs\": [\n");
+	} else {
+		printf("\nplayer,opponent,wins,losses,draws,win_rate,win_ci_low,win_ci_high,"
+			"mean_difference,difference_ci_low,difference_ci_high\n");
+	}
+	int pairs = t.players * (t.players - 1) / 2;
+	for (int a = 0, n = 0; a < t.players; ++a) {
+		for (int b = a + 1; b < t.players; ++b, ++n) {
+			const struct game_result *ra = &t.results[a * t.games], *rb = &t.results[b * t.games];
+			long wins = 0, losses = 0;
+			double mean = 0, var = 0;
+			for (int g = 0; g < t.games; ++g) {
+				wins += ra[g].score > rb[g].score;
+				losses += ra[g].score < rb[g].score;
+				mean += ra[g].score - rb[g].score;
+			}
+			mean /= t.games;
+			for (int g = 0; g < t.games; ++g) {
+				double d = ra[g].score - rb[g].score - mean;
+				var += d * d;
+			}
+			double half = Z95 * sqrt(var / (t.games - 1)) / sqrt(t.games);
+			long draws = t.games - wins - losses;
+			double rate = (wins + draws / 2.0) / t.games, rate_low, rate_high;
+			wilson(rate, t.games, &rate_low, &rate_high);
+
+			if (json == true) {
+				printf("  {\"player\": \"%s\", \"opponent\": \"%s\", \"wins\": %ld, \"losses\": %ld, "
+					"\"draws\": %ld, \"win_rate\": %.4f, \"win_ci\": [%.4f, %.4f], "
+					"\"mean_difference\": %.1f, \"difference_ci\": [%.1f, %.1f]}%s\n",
+					t.contestants[a].name, t.contestants[b].name, wins, losses, draws, rate, rate_low,
+					rate_high, mean, mean - half, mean + half, n + 1 < pairs ? "," : "");
+			} else {
+				printf("%s,%s,%ld,%ld,%ld,%.4f,%.4f,%.4f,%.1f,%.1f,%.1f\n", t.contestants[a].name,
+					t.contestants[b].name, wins, losses, draws, rate, rate_low, rate_high,
+					mean, mean - half, mean + half);
+			}
+		}
+	}
+	if (json == true) {
+		printf(" ]\n}\n");
+	}
+
+	for (int p = 0; p < t.players && t.summary != NULL; ++p) {
+		char path[512];
+		snprintf(path, sizeof(path), "%s%s.stats", t.summary, t.contestants[p].name);
+		if (stats_save(path, &t.stats[p]) == false) {
+			fprintf(stderr, "cannot write %s\n", path);
+			status = 1;
+		}
+	}
+
+	free(scores);
+	free(workers);
+	free(t.results);
+	free(t.played);
+	if (t.use_network == true) {
+		ntuple_close(&t.network);
+	}
+	eval_free(&t.evaluator);
+	return status;
+}
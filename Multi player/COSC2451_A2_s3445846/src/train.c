@@ -0,0 +1,511 @@
+/** @file train.c
+ * @brief This program learns the weights of an n-tuple network by
+ * self-play: the AI plays with the current weights and after every move
+ * the value of the previous board is moved towards the reward plus the
+ * value of the new board (TD(0) on the boards after each move). With
+ * --tc every weight gets its own learning rate (temporal coherence).
+ *
+ * All threads play on the same weights without locks: two threads rarely
+ * update the same weight at once and a lost update only slows learning.
+ *
+ * Every few episodes the state of the training (the weights, the tables of
+ * --tc, the summary of the games and the next episode, which is all the
+ * random numbers depend on) is written to a checkpoint: the threads finish
+ * the episodes before it, then a child process is forked and writes its
+ * copy-on-write view of the memory while the threads go on. While the last
+ * checkpoint is still being written the next one is put off a few episodes.
+ * --resume starts again from the checkpoint, and with 1 thread the result
+ * is the same as without stopping.
+ *
+ * Usage: ./train [-y size] [-e episodes] [-t threads] [-a alpha] [-s seed]
+ *                [-n tuples] [-i interval] [-o weights] [-d summary]
+ *                [-c checkpoint] [-k episodes] [--tc] [--resume]
+ * (default: -c train.ckpt -k 10000, -d writes the summary of the games
+ * for ./report, -k 0 only writes the checkpoint at the end)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <float.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "key_algorithm.h"
+#include "ntuple.h"
+#include "rng.h"
+#include "sim.h"
+#include "stats.h"
+
+#define CHECKPOINT_DELAY 64  /* episodes a checkpoint is put off while the last one is written */
+
+/** @struct Self-play shared by the threads.
+ */
+struct trainer {
+	struct ntuple *n; float *errors; float *absolute;  /* sums of the errors, NULL without --tc */
+	int y; long episodes; float alpha; unsigned int seed; long interval;
+	long next; pthread_mutex_t lock;
+	long done; double total; long reach2048; long long best; double started;  /* current interval */
+	struct stats *stats; struct stats *locals; int threads; int joined;  /* stats: the games before a resume */
+	const char *path; long every; long checkpoint; long saved; pid_t writer;  /* checkpoint: next one to write */
+	int playing; pthread_cond_t idle;  /* playing: episodes being played */
+};
+
+/** @brief Get the time in seconds.
+ * @return double
+ */
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/** @brief Move the value of a board by an error.
+ * @param tr the trainer
+ * @param a the exponents of the game board
+ * @param error target value minus current value
+ * @return none
+ */
+static void learn(struct trainer *tr, const unsigned char *a, float error) {
+	size_t index[NTUPLE_MAX_INDEXES];
+	int count = ntuple_indexes(tr->n, a, index);
+	float step = tr->alpha * error / count;  /* the error is shared by every weight used */
+
+	for (int i = 0; i < count; ++i) {
+		float rate = 1;
+		if (tr->errors != NULL) {  /* weights whose errors keep the same sign learn faster */
+			tr->errors[index[i]] += error;
+			tr->absolute[index[i]] += fabsf(error);
+			if (tr->absolute[index[i]] > 0) {
+				rate = fabsf(tr->errors[index[i]]) / tr->absolute[index[i]];
+			}
+		}
+		tr->n->weights[index[i]] += rate * step;
+	}
+}
+
+/** @brief Play one game and learn from every move.
+ * @param tr the trainer
+ * @param stream random numbers of the game
+ * @param r the result of the game
+ * @return none
+ */
+static void play(struct trainer *tr, struct rng_stream stream, struct game_result *r) {
+	int y = tr->y;
+	const struct moves *moves = get_moves(y);
+	unsigned char table[MAX_LENGTH * MAX_LENGTH], after[MAX_LENGTH * MAX_LENGTH];
+	unsigned char previous[MAX_LENGTH * MAX_LENGTH];
+	bool isFail = false, started = false;
+
+	memset(table, 0, sizeof(table));
+	memset(r, 0, sizeof(*r));
+	add_value_at(table, &isFail, &y, &stream, 0);
+	add_value_at(table, &isFail, &y, &stream, 1);
+
+	while (r->moves < SIM_MAX_MOVES) {
+		float largest = -FLT_MAX;
+		long long reward = 0;
+		for (int dir = 0; dir < 4; ++dir) {
+			unsigned char clone[MAX_LENGTH * MAX_LENGTH];
+			long long score = 0;
+			memcpy(clone, table, y * y);
+			if (move_table(moves, dir, clone, &score, &y) == true) {
+				float predict = score + ntuple_eval(tr->n, clone);
+				if (predict > largest) {
+					largest = predict;
+					reward = score;
+					memcpy(after, clone, y * y);
+				}
+			}
+		}
+		if (largest == -FLT_MAX) {
+			break;  /* nothing can move */
+		}
+
+		if (started == true) {
+			learn(tr, previous, largest - ntuple_eval(tr->n, previous));
+		}
+		memcpy(previous, after, y * y);
+		started = true;
+
+		memcpy(table, after, y * y);
+		r->score += reward;
+		r->moves++;
+		add_value_at(table, &isFail, &y, &stream, r->moves + 1);
+	}
+	if (started == true) {  /* nothing more can be won after the last move */
+		learn(tr, previous, -ntuple_eval(tr->n, previous));
+	}
+
+	for (int i = 0; i < y * y; ++i) {
+		if (table[i] > r->max_tile) {
+			r->max_tile = table[i];
+		}
+	}
+	memcpy(r->board, table, y * y);
+}
+
+/** @brief Add the summaries of the threads to the one of the games before a resume.
+ * @param tr the trainer
+ * @param total the summary of every game
+ * @return none
+ */
+static void total_stats(const struct trainer *tr, struct stats *total) {
+	*total = *tr->stats;
+	for (int i = 0; i < tr->threads; ++i) {
+		stats_merge(total, &tr->locals[i]);
+	}
+}
+
+/** @brief Write the checkpoint of the episodes before one: the weights,
+ * the tables of --tc and the summary go to files named after the episode,
+ * then the checkpoint file naming them is replaced and the files of the
+ * last checkpoint are removed.
+ * @param tr the trainer
+ * @param episode first episode not played
+ * @return false if a file cannot be written
+ */
+static bool save_checkpoint(const struct trainer *tr, long episode) {
+	static struct stats total;
+	char name[512], temp[512];
+	total_stats(tr, &total);
+
+	snprintf(name, sizeof(name), "%s.%ld.weights", tr->path, episode);
+	if (ntuple_save(tr->n, name) == false) {
+		return false;
+	}
+	snprintf(name, sizeof(name), "%s.%ld.stats", tr->path, episode);
+	if (stats_save(name, &total) == false) {
+		return false;
+	}
+	if (tr->errors != NULL) {
+		snprintf(name, sizeof(name), "%s.%ld.tc", tr->path, episode);
+		FILE *f = fopen(name, "wb");
+		if (!f) {
+			return false;
+		}
+		bool ok = fwrite(tr->errors, sizeof(float), tr->n->total, f) == tr->n->total
+			&& fwrite(tr->absolute, sizeof(float), tr->n->total, f) == tr->n->total;
+		if (fclose(f) != 0 || ok == false) {
+			return false;
+		}
+	}
+
+	snprintf(temp, sizeof(temp), "%s.tmp", tr->path);
+	FILE *f = fopen(temp, "w");
+	if (!f) {
+		return false;
+	}
+	fprintf(f, "episode %ld\ny %d\nseed %u\nalpha %.9g\ntc %d\n", episode, tr->y, tr->seed, tr->alpha,
+		tr->errors != NULL);
+	fprintf(f, "done %ld\ntotal %.17g\nreach2048 %ld\nbest %lld\n", tr->done, tr->total, tr->reach2048, tr->best);
+	if (fclose(f) != 0 || rename(temp, tr->path) != 0) {
+		return false;
+	}
+
+	const char *kinds[3] = {"weights", "stats", "tc"};
+	for (int k = 0; k < 3 && tr->saved >= 0 && tr->saved != episode; ++k) {
+		snprintf(name, sizeof(name), "%s.%ld.%s", tr->path, tr->saved, kinds[k]);
+		remove(name);
+	}
+	return true;
+}
+
+/** @brief Read a checkpoint and continue from it.
+ * @param path the checkpoint file
+ * @param tr the trainer, its summary must be allocated
+ * @param n the network, opened from the weights of the checkpoint
+ * @return false if there is no valid checkpoint
+ */
+static bool load_checkpoint(const char *path, struct trainer *tr, struct ntuple *n) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return false;
+	}
+	struct trainer t = *tr;
+	int tc;
+	bool ok = fscanf(f, "episode %ld\ny %d\nseed %u\nalpha %f\ntc %d\n", &t.next, &t.y, &t.seed,
+		&t.alpha, &tc) == 5
+		&& fscanf(f, "done %ld\ntotal %lf\nreach2048 %ld\nbest %lld\n", &t.done, &t.total,
+		&t.reach2048, &t.best) == 4;
+	fclose(f);
+
+	char name[512];
+	snprintf(name, sizeof(name), "%s.%ld.weights", path, t.next);
+	ok = ok && ntuple_open(n, name, true) == true;  /* a private copy of the file */
+	if (ok == false) {
+		return false;
+	}
+	snprintf(name, sizeof(name), "%s.%ld.stats", path, t.next);
+	ok = n->y == t.y && n->format == NTUPLE_FLOAT && stats_load(name, t.stats) == true;
+
+	if (ok == true && tc == 1) {
+		snprintf(name, sizeof(name), "%s.%ld.tc", path, t.next);
+		t.errors = malloc(n->total * sizeof(float));
+		t.absolute = malloc(n->total * sizeof(float));
+		f = fopen(name, "rb");
+		ok = f != NULL && t.errors != NULL && t.absolute != NULL
+			&& fread(t.errors, sizeof(float), n->total, f) == n->total
+			&& fread(t.absolute, sizeof(float), n->total, f) == n->total;
+		if (f != NULL) {
+			fclose(f);
+		}
+	}
+	if (ok == false) {
+		free(t.errors);
+		free(t.absolute);
+		ntuple_close(n);
+		return false;
+	}
+	*tr = t;
+	return true;
+}
+
+/** @brief Fork a child writing the checkpoint, every thread is waiting
+ * so the memory it sees is the state after the episodes before tr->next.
+ * The last child must be done first, they write the same files, but the
+ * threads never wait for it.
+ * @param tr the trainer
+ * @return false if the last child is still writing
+ */
+static bool snapshot(struct trainer *tr) {
+	if (tr->writer > 0 && waitpid(tr->writer, NULL, WNOHANG) == 0) {
+		return false;
+	}
+	tr->writer = 0;
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0) {
+		_exit(save_checkpoint(tr, tr->next) ? 0 : 1);
+	}
+	if (pid < 0) {
+		fprintf(stderr, "cannot fork to write %s\n", tr->path);
+		return true;
+	}
+	tr->writer = pid;
+	tr->saved = tr->next;
+	return true;
+}
+
+/** @brief Play games until every episode is done, the thread finishing
+ * an interval prints its statistics. The episodes after a checkpoint only
+ * start once the ones before it are done and it is written.
+ * @param param the trainer
+ * @return none
+ */
+static void *worker(void *param) {
+	struct trainer *tr = param;
+	pthread_mutex_lock(&tr->lock);
+	struct stats *local = &tr->locals[tr->joined++];
+	pthread_mutex_unlock(&tr->lock);
+
+	while (true) {
+		pthread_mutex_lock(&tr->lock);
+		while (tr->next == tr->checkpoint && tr->playing > 0) {
+			pthread_cond_wait(&tr->idle, &tr->lock);
+		}
+		if (tr->next == tr->checkpoint && tr->next < tr->episodes) {
+			if (snapshot(tr) == true) {
+				tr->checkpoint = (tr->next / tr->every + 1) * tr->every;
+			} else {
+				tr->checkpoint += CHECKPOINT_DELAY;
+			}
+		}
+		long episode = tr->next++;
+		tr->playing += episode < tr->episodes;
+		pthread_mutex_unlock(&tr->lock);
+		if (episode >= tr->episodes) {
+			break;
+		}
+
+		struct game_result r;
+		play(tr, rng_stream(tr->seed, 0, episode), &r);
+		stats_add(local, &r);
+
+		pthread_mutex_lock(&tr->lock);
+		if (--tr->playing == 0) {
+			pthread_cond_broadcast(&tr->idle);
+		}
+		tr->done++;
+		tr->total += r.score;
+		tr->reach2048 += r.max_tile >= 11;
+		if (r.score > tr->best) {
+			tr->best = r.score;
+		}
+		if (tr->done == tr->interval) {
+			double t = now();
+			printf("%10ld %12.1f %8.1f%% %10lld %10.1f\n", episode + 1, tr->total / tr->done,
+				100.0 * tr->reach2048 / tr->done, tr->best, tr->done / (t - tr->started));
+			fflush(stdout);
+			tr->done = 0;
+			tr->total = 0;
+			tr->reach2048 = 0;
+			tr->best = 0;
+			tr->started = t;
+		}
+		pthread_mutex_unlock(&tr->lock);
+	}
+	return NULL;
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	int y = 4, threads = sysconf(_SC_NPROCESSORS_ONLN);
+	long episodes = 100000, interval = 1000, every = 10000;
+	float alpha = -1;
+	unsigned int seed = 1;
+	const char *spec = NULL;
+	const char *output = NTUPLE_FILE;
+	const char *summary = NULL;
+	const char *checkpoint = "train.ckpt";
+	bool tc = false, resume = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--tc") == 0) {
+			tc = true;
+		} else if (strcmp(argv[i], "--resume") == 0) {
+			resume = true;
+		} else if (i + 1 < argc && strcmp(argv[i], "-y") == 0) {
+			y = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-e") == 0) {
+			episodes = atol(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+			threads = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-a") == 0) {
+			alpha = atof(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			seed = strtoul(argv[++i], NULL, 10);
+		} else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+			spec = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-i") == 0) {
+			interval = atol(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+			output = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-d") == 0) {
+			summary = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+			checkpoint = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-k") == 0) {
+			every = atol(argv[++i]);
+		} else {
+			fprintf(stderr, "usage: %s [-y size] [-e episodes] [-t threads] [-a alpha] [-s seed] "
+				"[-n tuples] [-i interval] [-o weights] [-d summary] [-c checkpoint] [-k episodes] "
+				"[--tc] [--resume]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (y < 3 || y > MAX_LENGTH || episodes < 1 || threads < 1 || interval < 1 || every < 0) {
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+	if (alpha < 0) {
+		alpha = tc ? 1.0f : 0.1f;
+	}
+
+	struct trainer tr;
+	struct ntuple n;
+	memset(&tr, 0, sizeof(tr));
+	tr.stats = malloc(sizeof(struct stats));
+	tr.locals = malloc(threads * sizeof(struct stats));
+	if (tr.stats == NULL || tr.locals == NULL) {
+		fprintf(stderr, "no memory for the summary\n");
+		return 1;
+	}
+	tr.y = y;
+	tr.alpha = alpha;
+	tr.seed = seed;
+	tr.saved = -1;
+	if (resume == true && load_checkpoint(checkpoint, &tr, &n) == true) {  /* the options of the checkpoint */
+		printf("resuming at episode %ld of %s\n", tr.next, checkpoint);
+		y = tr.y;
+		tr.saved = tr.next;
+	} else if (resume == true) {  /* keep learning on the saved weights */
+		if (ntuple_open(&n, output, true) == false || n.y != y || n.format != NTUPLE_FLOAT) {
+			fprintf(stderr, "cannot resume from %s\n", output);
+			return 1;
+		}
+		stats_init(tr.stats, y);
+	} else {
+		if (ntuple_parse(&n, y, spec) == false) {
+			fprintf(stderr, "invalid tuples: %s\n", spec);
+			return 1;
+		}
+		if (ntuple_create(&n) == false) {
+			fprintf(stderr, "no memory for %zu weights\n", n.total);
+			return 1;
+		}
+		stats_init(tr.stats, y);
+	}
+
+	tr.n = &n;
+	tr.episodes = episodes;
+	tr.interval = interval;
+	tr.threads = threads;
+	tr.path = checkpoint;
+	tr.every = every;
+	tr.checkpoint = every > 0 ? (tr.next / every + 1) * every : episodes;
+	tr.started = now();
+	pthread_mutex_init(&tr.lock, NULL);
+	pthread_cond_init(&tr.idle, NULL);
+	for (int i = 0; i < threads; ++i) {
+		stats_init(&tr.locals[i], y);
+	}
+	if (tc == true && tr.errors == NULL) {
+		tr.errors = calloc(n.total, sizeof(float));
+		tr.absolute = calloc(n.total, sizeof(float));
+		if (tr.errors == NULL || tr.absolute == NULL) {
+			fprintf(stderr, "no memory for temporal coherence\n");
+			return 1;
+		}
+	}
+
+	printf("%d tuples, %zu weights (%zu MB)\n", n.count, n.total, n.total * sizeof(float) >> 20);
+	printf("%10s %12s %9s %10s %10s\n", "episodes", "mean score", "2048%", "best", "games/s");
+	pthread_t *workers = malloc(threads * sizeof(pthread_t));
+	for (int i = 0; i < threads; ++i) {
+		pthread_create(&workers[i], NULL, worker, &tr);
+	}
+	for (int i = 0; i < threads; ++i) {
+		pthread_join(workers[i], NULL);
+	}
+
+	if (tr.writer > 0) {
+		waitpid(tr.writer, NULL, 0);
+	}
+
+	/* the last checkpoint, --resume with more episodes goes on from it */
+	int status = 0;
+	if (tr.saved < episodes && save_checkpoint(&tr, episodes) == false) {
+		fprintf(stderr, "cannot write %s\n", checkpoint);
+		status = 1;
+	}
+	if (ntuple_save(&n, output) == false) {
+		fprintf(stderr, "cannot write %s\n", output);
+		status = 1;
+	}
+	struct stats *total = malloc(sizeof(struct stats));
+	if (summary != NULL && total != NULL) {
+		total_stats(&tr, total);
+	}
+	if (summary != NULL && (total == NULL || stats_save(summary, total) == false)) {
+		fprintf(stderr, "cannot write %s\n", summary);
+		status = 1;
+	}
+	free(total);
+	free(tr.stats);
+	free(tr.locals);
+	free(workers);
+	free(tr.errors);
+	free(tr.absolute);
+	ntuple_close(&n);
+	return status;
+}
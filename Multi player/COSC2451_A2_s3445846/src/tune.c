@@ -0,0 +1,315 @@
+/** @file tune.c
+ * @brief This program tunes the weights of the evaluation with the
+ * cross-entropy method: every generation samples weight vectors around
+ * the current mean, plays seeded games with each of them on all cores
+ * and moves the mean to the best quarter of the vectors.
+ *
+ * Usage: ./tune [-g generations] [-p population] [-n games] [-y size]
+ *               [-t threads] [-s seed] [-c checkpoint] [-o weights] [--resume]
+ * (--resume continues the experiment of the checkpoint: its population,
+ * games, size and seed replace -p, -n, -y and -s)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "key_algorithm.h"
+#include "eval.h"
+#include "rng.h"
+#include "sim.h"
+#include "ai.h"
+
+#define MAX_POPULATION 256
+
+/** @struct State of the tuner, saved in the checkpoint after every generation.
+ */
+struct tuner {
+	int y; int population; int games;  /* the experiment, a resumed run keeps it */
+	int generation; unsigned int games_seed; unsigned int seed; float best_score;
+	float mean[EVAL_TERMS]; float sigma[EVAL_TERMS]; struct weights best;
+};
+
+/** @struct Work shared by the threads of one generation.
+ */
+struct batch {
+	int y; int population; int games; int generation; unsigned int seed;
+	struct evaluator *evaluators; struct game_result *results;
+	int next; pthread_mutex_t lock;
+};
+
+/** @brief Draw a number from the normal distribution (Box-Muller).
+ * @param seed random seed
+ * @return double
+ */
+static double gaussian(unsigned int *seed) {
+	double u = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+	double v = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+	return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/** @brief Play the games of a generation until there is none left.
+ * @param param the batch
+ * @return none
+ */
+static void *worker(void *param) {
+	struct batch *b = param;
+
+	while (true) {
+		pthread_mutex_lock(&b->lock);
+		int job = b->next++;
+		pthread_mutex_unlock(&b->lock);
+		if (job >= b->population * b->games) {
+			break;
+		}
+
+		int candidate = job / b->games;
+		int game = job % b->games;  /* every weight vector plays the same games */
+		sim_play(b->y, rng_stream(b->seed, b->generation, game), ai_greedy,
+			&b->evaluators[candidate], &b->results[job]);
+	}
+	return NULL;
+}
+
+/** @brief Write the state of the tuner, the old checkpoint is only
+ * replaced once the new one is complete.
+ * @param path the checkpoint file
+ * @param t the tuner
+ * @return false if the file cannot be written
+ */
+static bool save_checkpoint(const char *path, const struct tuner *t) {
+	char temp[512];
+	snprintf(temp, sizeof(temp), "%s.tmp", path);
+	FILE *f = fopen(temp, "w");
+	if (!f) {
+		return false;
+	}
+
+	fprintf(f, "size %d\npopulation %d\ngames %d\n", t->y, t->population, t->games);
+	fprintf(f, "generation %d\ngames_seed %u\nseed %u\nbest_score %.9g\n",
+		t->generation, t->games_seed, t->seed, t->best_score);
+	const float *rows[3] = {t->mean, t->sigma, t->best.value};
+	const char *names[3] = {"mean", "sigma", "best"};
+	for (int r = 0; r < 3; ++r) {
+		fprintf(f, "%s", names[r]);
+		for (int i = 0; i < EVAL_TERMS; ++i) {
+			fprintf(f, " %.9g", rows[r][i]);
+		}
+		fprintf(f, "\n");
+	}
+
+	if (fclose(f) != 0) {
+		return false;
+	}
+	return rename(temp, path) == 0;
+}
+
+/** @brief Read the state of the tuner.
+ * @param path the checkpoint file
+ * @param t the tuner
+ * @return false if there is no valid checkpoint
+ */
+static bool load_checkpoint(const char *path, struct tuner *t) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return false;
+	}
+
+	bool ok = fscanf(f, "size %d\npopulation %d\ngames %d\n", &t->y, &t->population, &t->games) == 3
+		&& fscanf(f, "generation %d\ngames_seed %u\nseed %u\nbest_score %f\n",
+		&t->generation, &t->games_seed, &t->seed, &t->best_score) == 4;
+	float *rows[3] = {t->mean, t->sigma, t->best.value};
+	const char *names[3] = {"mean", "sigma", "best"};
+	for (int r = 0; r < 3 && ok; ++r) {
+		char name[16];
+		ok = fscanf(f, "%15s", name) == 1 && strcmp(name, names[r]) == 0;
+		for (int i = 0; i < EVAL_TERMS && ok; ++i) {
+			ok = fscanf(f, "%f", &rows[r][i]) == 1;
+		}
+	}
+
+	fclose(f);
+	return ok;
+}
+
+static const double *sort_scores;  /* mean score of every weight vector, for by_score() */
+
+/** @brief Sort the weight vectors by their mean score, best first.
+ * @param a first candidate
+ * @param b second candidate
+ * @return int
+ */
+static int by_score(const void *a, const void *b) {
+	double sa = sort_scores[*(const int *) a], sb = sort_scores[*(const int *) b];
+	return sa < sb ? 1 : sa > sb ? -1 : *(const int *) a - *(const int *) b;
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return integer
+ */
+int main(int argc, char *argv[]) {
+	int generations = 50, population = 32, games = 64, y = 4;
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int seed = 1;
+	const char *checkpoint = "tune.ckpt";
+	const char *output = EVAL_FILE;
+	bool resume = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--resume") == 0) {
+			resume = true;
+		} else if (i + 1 < argc && strcmp(argv[i], "-g") == 0) {
+			generations = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-p") == 0) {
+			population = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+			games = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-y") == 0) {
+			y = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+			threads = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			seed = strtoul(argv[++i], NULL, 10);
+		} else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+			checkpoint = argv[++i];
+		} else if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+			output = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [-g generations] [-p population] [-n games] [-y size] "
+				"[-t threads] [-s seed] [-c checkpoint] [-o weights] [--resume]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	struct tuner t;
+	if (resume == true) {
+		if (load_checkpoint(checkpoint, &t) == false) {
+			fprintf(stderr, "cannot resume from %s\n", checkpoint);
+			return 1;
+		}
+		y = t.y;
+		population = t.population;
+		games = t.games;
+		printf("resuming at generation %d (population %d, %d games, size %d, seed %u)\n",
+			t.generation, population, games, y, t.games_seed);
+	}
+	if (population < 4 || population > MAX_POPULATION || games < 1 || threads < 1 || y < 3 || y > MAX_LENGTH) {
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+	if (resume == false) {  /* start around the current weights */
+		struct weights w;
+		eval_default_weights(&w);
+		eval_load_weights(output, &w);
+		t.y = y;
+		t.population = population;
+		t.games = games;
+		t.generation = 0;
+		t.games_seed = seed;
+		t.seed = seed;
+		t.best_score = -1;
+		t.best = w;
+		for (int i = 0; i < EVAL_TERMS; ++i) {
+			t.mean[i] = w.value[i];
+			t.sigma[i] = fabsf(w.value[i]) * 0.5f + 1.0f;
+		}
+	}
+
+	struct batch b;
+	b.y = y;
+	b.population = population;
+	b.games = games;
+	b.evaluators = malloc(population * sizeof(struct evaluator));
+	b.results = malloc(population * games * sizeof(struct game_result));
+	pthread_mutex_init(&b.lock, NULL);
+	pthread_t *workers = malloc(threads * sizeof(pthread_t));
+	struct weights candidates[MAX_POPULATION];
+	double scores[MAX_POPULATION];
+	int order[MAX_POPULATION];
+
+	printf("%4s %10s %10s %8s %8s   best weights\n", "gen", "mean", "best", "2048%", "4096%");
+	while (t.generation < generations) {
+		/* sample the weight vectors, the random state is part of the checkpoint */
+		for (int c = 0; c < population; ++c) {
+			for (int i = 0; i < EVAL_TERMS; ++i) {
+				candidates[c].value[i] = t.mean[i] + t.sigma[i] * gaussian(&t.seed);
+			}
+			eval_init(&b.evaluators[c], y, &candidates[c]);
+		}
+
+		b.generation = t.generation;
+		b.seed = t.games_seed;
+		b.next = 0;
+		for (int i = 0; i < threads; ++i) {
+			pthread_create(&workers[i], NULL, worker, &b);
+		}
+		for (int i = 0; i < threads; ++i) {
+			pthread_join(workers[i], NULL);
+		}
+
+		double total = 0;
+		long reach2048 = 0, reach4096 = 0;
+		for (int c = 0; c < population; ++c) {
+			scores[c] = 0;
+			for (int g = 0; g < games; ++g) {
+				struct game_result *r = &b.results[c * games + g];
+				scores[c] += r->score;
+				reach2048 += r->max_tile >= 11;
+				reach4096 += r->max_tile >= 12;
+			}
+			scores[c] /= games;
+			total += scores[c];
+			order[c] = c;
+			eval_free(&b.evaluators[c]);
+		}
+
+		/* move the distribution to the elite quarter */
+		sort_scores = scores;
+		qsort(order, population, sizeof(int), by_score);
+		int elite = population / 4;
+		for (int i = 0; i < EVAL_TERMS; ++i) {
+			double mean = 0, var = 0;
+			for (int e = 0; e < elite; ++e) {
+				mean += candidates[order[e]].value[i];
+			}
+			mean /= elite;
+			for (int e = 0; e < elite; ++e) {
+				double d = candidates[order[e]].value[i] - mean;
+				var += d * d;
+			}
+			t.mean[i] = mean;
+			t.sigma[i] = sqrt(var / elite) + 1.0;  /* keep exploring a little */
+		}
+		if (scores[order[0]] > t.best_score) {
+			t.best_score = scores[order[0]];
+			t.best = candidates[order[0]];
+		}
+
+		long all = (long) population * games;
+		printf("%4d %10.1f %10.1f %7.1f%% %7.1f%%  ", t.generation, total / population,
+			scores[order[0]], 100.0 * reach2048 / all, 100.0 * reach4096 / all);
+		for (int i = 0; i < EVAL_TERMS; ++i) {
+			printf(" %s=%g", eval_term_name(i), t.best.value[i]);
+		}
+		printf("\n");
+		fflush(stdout);
+
+		t.generation++;
+		eval_save_weights(output, &t.best);
+		if (save_checkpoint(checkpoint, &t) == false) {
+			fprintf(stderr, "cannot write %s\n", checkpoint);
+		}
+	}
+
+	free(workers);
+	free(b.results);
+	free(b.evaluators);
+	return 0;
+}
@@ -0,0 +1,275 @@
+/** @file verify.c
+ * @brief This program checks replays before their scores go to the score
+ * list: every replay is played again from its random numbers on all
+ * cores (replay.c), and only the scores of the valid ones are written to
+ * score.sav (the scores of games played in 2048 go to unverified.sav, no
+ * replay backs them). A line that is not a replay is reported and skipped.
+ * It can also write replays of games played by an AI level,
+ * to try the checks on many games.
+ *
+ * Usage: ./verify [-t threads] [-a] [replays...]
+ *        ./verify -g games [-l level] [-y size] [-s seed] > replays
+ * (default: the replays are read from stdin, -a writes the scores of the
+ * valid replays to score.sav, -g writes the replays of games of the AI
+ * level, default -l 3 -y 4 -s 1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "key_algorithm.h"
+#include "score.h"
+#include "search.h"
+#include "rng.h"
+#include "sim.h"
+#include "ai.h"
+#include "replay.h"
+
+#define VERIFY_BATCH 64  /* replays a thread takes at once */
+
+/** @struct Replays shared by the threads, each one writes the checks of its replays only.
+ */
+struct verifier {
+	struct replay *replays; long count;
+	int *results; long *illegal; long long *made;  /* per replay */
+	long next; pthread_mutex_t lock;
+};
+
+/** @struct Policy of an AI level that keeps the directions of its moves.
+ */
+struct recorder {
+	struct ai_player *player; struct replay *replay; long size; bool failed;  /* failed: no memory for the moves */
+};
+
+/** @brief Get the current time in seconds.
+ * @return double
+ */
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/** @brief Choose a move with the AI level and add it to the replay.
+ * @param ctx the recorder
+ * @param a the exponents of the game board
+ * @param y colum length of game board
+ * @return the direction, -1 if nothing can move or there is no memory to keep it
+ */
+static int record(void *ctx, const unsigned char *a, int y) {
+	struct recorder *rec = ctx;
+	int dir = ai_driver(rec->player, a, y);
+	if (dir < 0) {
+		return dir;
+	}
+	if (rec->replay->count == rec->size) {
+		long size = rec->size > 0 ? rec->size * 2 : 1024;
+		unsigned char *moves = realloc(rec->replay->moves, size);
+		if (moves == NULL) {
+			rec->failed = true;
+			return -1;
+		}
+		rec->replay->moves = moves;
+		rec->size = size;
+	}
+	rec->replay->moves[rec->replay->count++] = dir;
+	return dir;
+}
+
+/** @brief Check batches of replays until there is none left.
+ * @param param the verifier
+ * @return none
+ */
+static void *worker(void *param) {
+	struct verifier *v = param;
+	while (true) {
+		pthread_mutex_lock(&v->lock);
+		long first = v->next;
+		v->next += VERIFY_BATCH;
+		pthread_mutex_unlock(&v->lock);
+		if (first >= v->count) {
+			break;
+		}
+
+		for (long i = first; i < first + VERIFY_BATCH && i < v->count; ++i) {
+			v->results[i] = replay_verify(&v->replays[i], &v->illegal[i], &v->made[i]);
+		}
+	}
+	return NULL;
+}
+
+/** @brief Write the replays of games played by an AI level.
+ * @param games number of games
+ * @param level the AI level (0 to AI_LEVELS - 1)
+ * @param y colum length of game board
+ * @param seed seed of the games
+ * @return false if there is no memory for a game
+ */
+static bool generate(long games, int level, int y, unsigned int seed) {
+	for (long g = 0; g < games; ++g) {
+		struct replay r;
+		struct recorder rec;
+		struct game_result result;
+		struct rng_stream stream = rng_stream(seed, 0, g);
+
+		memset(&r, 0, sizeof(r));
+		snprintf(r.name, sizeof(r.name), "AI%d", level + 1);
+		r.y = y;
+		r.seed = seed;
+		r.game = g;
+		rec.player = ai_player_start(y, level, SEARCH_CUTOFF, &stream);
+		rec.replay = &r;
+		rec.size = 0;
+		rec.failed = false;
+		if (rec.player == NULL) {
+			return false;
+		}
+		sim_play(y, stream, record, &rec, &result);
+		ai_player_stop(rec.player);
+		if (rec.failed == true) {
+			replay_free(&r);
+			return false;
+		}
+
+		r.score = result.score;
+		replay_write(stdout, &r);
+		replay_free(&r);
+	}
+	return true;
+}
+
+/**
+ * @brief Main function.
+ * @param argc number of arguments
+ * @param argv options (see the top of the file)
+ * @return 0 if every replay is valid
+ */
+int main(int argc, char *argv[]) {
+	int threads = sysconf(_SC_NPROCESSORS_ONLN), level = 3, y = 4;
+	long games = 0;
+	unsigned int seed = 1;
+	bool accept = false;
+	int first = argc;
+
+	for (int i = 1; i < argc && first == argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-a") == 0) {
+			accept = true;
+		} else if (i + 1 < argc && strcmp(argv[i], "-g") == 0) {
+			games = atol(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-l") == 0) {
+			level = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-y") == 0) {
+			y = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			seed = strtoul(argv[++i], NULL, 10);
+		} else if (argv[i][0] != '-') {
+			first = i;
+		} else {
+			fprintf(stderr, "usage: %s [-t threads] [-a] [replays...]\n"
+				"       %s -g games [-l level] [-y size] [-s seed]\n", argv[0], argv[0]);
+			return 1;
+		}
+	}
+	if (threads < 1 || games < 0 || level < 1 || level > AI_LEVELS || y < 3 || y > MAX_LENGTH) {
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+	if (games > 0) {
+		if (generate(games, level - 1, y, seed) == false) {
+			fprintf(stderr, "no memory to play the games\n");
+			return 1;
+		}
+		return 0;
+	}
+
+	/* read every replay, then check them on all cores */
+	struct verifier v;
+	long size = 0;
+	memset(&v, 0, sizeof(v));
+	for (int i = first; i < argc || i == first; ++i) {
+		FILE *f = i < argc ? fopen(argv[i], "r") : stdin;
+		if (!f) {
+			fprintf(stderr, "cannot read %s\n", argv[i]);
+			return 1;
+		}
+		while (true) {
+			if (v.count == size) {
+				size = size > 0 ? size * 2 : 1024;
+				v.replays = realloc(v.replays, size * sizeof(struct replay));
+				if (v.replays == NULL) {
+					fprintf(stderr, "no memory for the replays\n");
+					return 1;
+				}
+			}
+			if (replay_read(f, &v.replays[v.count]) == false) {
+				break;
+			}
+			v.count++;
+		}
+		if (f != stdin) {
+			fclose(f);
+		}
+	}
+
+	v.results = malloc((v.count + 1) * sizeof(int));
+	v.illegal = malloc((v.count + 1) * sizeof(long));
+	v.made = malloc((v.count + 1) * sizeof(long long));
+	if (v.results == NULL || v.illegal == NULL || v.made == NULL) {
+		fprintf(stderr, "no memory for the replays\n");
+		return 1;
+	}
+	double start = now();
+	pthread_mutex_init(&v.lock, NULL);
+	pthread_t *workers = malloc(threads * sizeof(pthread_t));
+	int started = 0;
+	while (workers != NULL && started < threads && pthread_create(&workers[started], NULL, worker, &v) == 0) {
+		started++;
+	}
+	if (started == 0) {
+		worker(&v);  /* no thread could start: check them on this one */
+	}
+	for (int i = 0; i < started; ++i) {
+		pthread_join(workers[i], NULL);
+	}
+	double seconds = now() - start;
+
+	/* the failures and the accepted scores in the order of the replays */
+	long valid = 0, moves = 0;
+	for (long i = 0; i < v.count; ++i) {
+		const struct replay *r = &v.replays[i];
+		moves += r->count;
+		if (v.results[i] == REPLAY_VALID) {
+			valid++;
+			if (accept == true) {
+				append_score(SCORE_FILE, r->name, r->score);
+			}
+		} else if (v.results[i] == REPLAY_ILLEGAL) {
+			printf("replay %ld (%s): move %ld does not move the board\n", i + 1, r->name, v.illegal[i] + 1);
+		} else if (v.results[i] == REPLAY_SCORE) {
+			printf("replay %ld (%s): score %lld, the moves make %lld\n", i + 1, r->name, r->score, v.made[i]);
+		} else if (v.results[i] == REPLAY_FORMAT) {
+			printf("replay %ld: the line is not a replay\n", i + 1);
+		} else {
+			printf("replay %ld (%s): no board of size %d\n", i + 1, r->name, r->y);
+		}
+	}
+	printf("%ld replays, %ld valid, %ld moves in %.3f s (%.2f M moves/s)\n", v.count, valid, moves, seconds,
+		seconds > 0 ? moves / seconds / 1e6 : 0.0);
+
+	for (long i = 0; i < v.count; ++i) {
+		replay_free(&v.replays[i]);
+	}
+	free(v.replays);
+	free(v.results);
+	free(v.illegal);
+	free(v.made);
+	free(workers);
+	return valid == v.count ? 0 : 1;
+}